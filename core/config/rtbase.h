@@ -767,6 +767,23 @@ typedef const char         *rt_pstr;
 #define RT_MIN(a, b)        ((a) < (b) ? (a) : (b))
 #define RT_MAX(a, b)        ((a) > (b) ? (a) : (b))
 
+/*
+ * Atomic add for 32-bit counters shared between threads,
+ * returns the value before the addition
+ */
+#if   (defined RT_WIN32) /* Win32, MSVC -------- for older versions --------- */
+
+#include <intrin.h>
+
+#define RT_ATOMIC_ADD(p, v) (_InterlockedExchangeAdd((volatile long *)(p),  \
+                                                     (long)(v)))
+
+#else /* --- Win64, GCC --- Linux, GCC -------------------------------------- */
+
+#define RT_ATOMIC_ADD(p, v) (__sync_fetch_and_add((p), (v)))
+
+#endif /* ------------- OS specific ----------------------------------------- */
+
 /*
  * Vector components
  */
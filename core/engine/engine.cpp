@@ -26,11 +26,22 @@
  * to the rendering backend once all data structures have been prepared.
  *
  * Update in turn consists of five phases:
- * 0.5 phase (sequential) - hierarchical update of arrays' transform matrices
+ * 0.5 phase (mostly parallel) - hierarchical update of arrays' transform matrices
  * 1st phase (multi-threaded) - update surfaces' transform matrices, data fields
  * 2nd phase (multi-threaded) - update surfaces' clip lists, bounds, tile lists
- * 2.5 phase (sequential) - hierarchical update of arrays' bounds from surfaces
- * 3rd phase (multi-threaded) - build updated cross-surface lists
+ * 2.5 phase (mostly parallel) - hierarchical update of arrays' bounds from surfaces
+ * 3rd phase (multi-threaded) - build global and cross-surface lists, tile lists
+ *
+ * For phases 0.5 and 2.5 the hierarchy is split into top arrays (sequential)
+ * and sub-trees below them, which are handed out to threads. Animators are
+ * called sequentially beforehand as object instances share scene data.
+ * Sub-trees contributing to bvnodes outside of them (or vice versa) or having
+ * trnode up in the hierarchy are left for the sequential part of phase 2.5.
+ *
+ * In pipelined mode (opt-in) the render of the frame updated by the previous
+ * call overlaps with phase 0.5 of the next frame, which doesn't touch any data
+ * used by the rendering backend, thus the output lags by one call.
+ * Phases 1 to 3 are not overlapped as they write SIMD-structures in place.
  *
  * Some parts of the update are handled by the object hierarchy (object.cpp),
  * while engine performs building of surface's node, clip and tile lists,
@@ -38,6 +49,12 @@
  *
  * Both update and render support multi-threading and use array of SceneThread
  * objects to separate working datasets and therefore avoid thread locking.
+ * Each job handed to the thread-pool carries its scene, thus several scenes
+ * of the same platform can be rendered concurrently from different threads.
+ *
+ * Async render (opt-in) hands frames to a per-scene thread, which renders them
+ * into a ring of output frames in the order of submission, each frame is
+ * marked with a fence, which the caller can poll or wait for.
  */
 
 /******************************************************************************/
@@ -422,52 +439,83 @@ rt_void print_lst(rt_pstr mgn, rt_ELEM *elm)
 
 /*
  * Initialize platform-specific pool of "thnum" threads (< 0 - no feedback).
- * Local stub below is used when platform threading functions are not provided
- * or during state-logging.
+ * Built-in thread pool (system.cpp) is used
+ * when platform threading functions are not provided.
  */
 static
 rt_void* init_threads(rt_si32 thnum, rt_Platform *pfm)
 {
+    rt_ThreadPool *pool = new rt_ThreadPool(RT_ABS32(thnum), RT_POOL_SPIN);
+
     if (thnum > 0)
     {
-        pfm->set_thnum(thnum); /* dummy feedback, pass core-count in platform */
+        pfm->set_thnum(pool->get_thnum());
     }
 
-    return pfm;
+    return pool;
 }
 
 /*
  * Terminate platform-specific pool of "thnum" threads.
- * Local stub below is used when platform threading functions are not provided
- * or during state-logging.
+ * Built-in thread pool (system.cpp) is used
+ * when platform threading functions are not provided.
  */
 static
 rt_void term_threads(rt_void *tdata, rt_si32 thnum)
 {
+    delete (rt_ThreadPool *)tdata;
+}
 
+/*
+ * Run update slice of the scene with given "index" on the built-in pool.
+ */
+static
+rt_void slice_update(rt_pntr data, rt_si32 index, rt_si32 phase)
+{
+    ((rt_Scene *)data)->update_slice(index, phase);
 }
 
 /*
- * Task platform-specific pool of "thnum" threads to update scene,
+ * Run render slice of the scene with given "index" on the built-in pool.
+ */
+static
+rt_void slice_render(rt_pntr data, rt_si32 index, rt_si32 phase)
+{
+    ((rt_Scene *)data)->render_slice(index, phase);
+}
+
+/*
+ * Task built-in pool of "thnum" threads to update scene "scn",
  * block until finished.
- * Local stub below is used when platform threading functions are not provided
- * or during state-logging. Simulate threading with sequential run.
  */
 static
-rt_void update_scene(rt_void *tdata, rt_si32 thnum, rt_si32 phase)
+rt_void update_pool(rt_void *tdata, rt_Scene *scn,
+                    rt_si32 thnum, rt_si32 phase)
 {
-    rt_Scene *scn;
+    ((rt_ThreadPool *)tdata)->run(slice_update, scn, phase);
+}
 
-    if (thnum < 0)
-    {
-        scn = (rt_Scene *)tdata;
-        thnum = -thnum;
-    }
-    else
-    {
-        scn = ((rt_Platform *)tdata)->get_cur_scene();
-    }
+/*
+ * Task built-in pool of "thnum" threads to render scene "scn",
+ * block until finished.
+ */
+static
+rt_void render_pool(rt_void *tdata, rt_Scene *scn,
+                    rt_si32 thnum, rt_si32 phase)
+{
+    ((rt_ThreadPool *)tdata)->run(slice_render, scn, phase);
+}
 
+/*
+ * Task platform-specific pool of "thnum" threads to update scene,
+ * block until finished.
+ * Local stub below is used when threading is off or during state-logging.
+ * Simulate threading with sequential run.
+ */
+static
+rt_void update_scene(rt_void *tdata, rt_Scene *scn,
+                     rt_si32 thnum, rt_si32 phase)
+{
     rt_si32 i;
 
     for (i = 0; i < thnum; i++)
@@ -479,24 +527,13 @@ rt_void update_scene(rt_void *tdata, rt_si32 thnum, rt_si32 phase)
 /*
  * Task platform-specific pool of "thnum" threads to render scene,
  * block until finished.
- * Local stub below is used when platform threading functions are not provided
- * or during state-logging. Simulate threading with sequential run.
+ * Local stub below is used when threading is off or during state-logging.
+ * Simulate threading with sequential run.
  */
 static
-rt_void render_scene(rt_void *tdata, rt_si32 thnum, rt_si32 phase)
+rt_void render_scene(rt_void *tdata, rt_Scene *scn,
+                     rt_si32 thnum, rt_si32 phase)
 {
-    rt_Scene *scn;
-
-    if (thnum < 0)
-    {
-        scn = (rt_Scene *)tdata;
-        thnum = -thnum;
-    }
-    else
-    {
-        scn = ((rt_Platform *)tdata)->get_cur_scene();
-    }
-
     rt_si32 i;
 
     for (i = 0; i < thnum; i++)
@@ -550,8 +587,11 @@ rt_Platform::rt_Platform(rt_FUNC_ALLOC f_alloc, rt_FUNC_FREE f_free,
     {
         this->f_init = init_threads;
         this->f_term = term_threads;
-        this->f_update = update_scene;
-        this->f_render = render_scene;
+        this->f_update = update_pool;
+        this->f_render = render_pool;
+
+        /* built-in pool takes all CPUs by default */
+        thnum = thnum != 0 ? thnum : rt_ThreadPool::get_cpus();
     }
 
     /* init thread management variables */
@@ -820,11 +860,14 @@ rt_Platform::~rt_Platform()
 /******************************************************************************/
 
 /*
- * Allocate scene thread in custom heap.
+ * Allocate scene thread in custom heap,
+ * each on its own cache lines as threads update their fields.
  */
 rt_pntr rt_SceneThread::operator new(size_t size, rt_Heap *hp)
 {
-    return hp->alloc(size, RT_ALIGN);
+    size = (size + RT_CACHE_LINE - 1) & ~(RT_CACHE_LINE - 1);
+
+    return hp->alloc(size, RT_CACHE_LINE);
 }
 
 rt_void rt_SceneThread::operator delete(rt_pntr ptr)
@@ -935,6 +978,14 @@ rt_SceneThread::rt_SceneThread(rt_Scene *scene, rt_si32 index) :
 
     memset(s_cam, 0, sizeof(rt_SIMD_CAMERA));
 
+    /* allocate occluder cache slots for shadow rays,
+     * slots are cleared in Scene before each render */
+    if (RT_SHW_SLOTS > 0)
+    {
+        s_inf->shw_p = alloc(sizeof(rt_ELEM) * RT_SHW_SLOTS, RT_QUAD_ALIGN);
+        s_inf->shw_m = RT_SHW_SLOTS - 1;
+    }
+
     /* allocate ctx SIMD structure */
     s_ctx = (rt_SIMD_CONTEXT *)
             alloc(sizeof(rt_SIMD_CONTEXT) + /* +1 context step for shadows */
@@ -948,6 +999,19 @@ rt_SceneThread::rt_SceneThread(rt_Scene *scene, rt_si32 index) :
     /* estimates are done in Scene once all counters have been initialized */
     msize = 0;
 
+    /* cache pool is set by Scene from the frame in which lists are built */
+    cpool = RT_NULL;
+
+    /* SIMD-buffers are allocated in Scene's 3rd update phase */
+    bfr_p = RT_NULL;
+    bfr_num = 0;
+
+    /* scratch for bvnode tree is allocated in "btree" and Scene's 3rd phase */
+    tree_elm = RT_NULL;
+
+    /* tile-rows counter is reset in Scene before each render */
+    tiles_taken = 0;
+
     /* allocate misc arrays for tiling */
     txmin = (rt_si32 *)alloc(sizeof(rt_si32) * scene->tiles_in_col, RT_ALIGN);
     txmax = (rt_si32 *)alloc(sizeof(rt_si32) * scene->tiles_in_col, RT_ALIGN);
@@ -1770,8 +1834,8 @@ rt_ELEM* rt_SceneThread::filter(rt_Object *obj, rt_ELEM **ptr)
  */
 rt_void rt_SceneThread::snode(rt_Surface *srf)
 {
-    /* as temporary memory pool is released after every frame,
-     * always rebuild the list even if the scene hasn't changed */
+    /* the list is kept in thread's cache pool across frames,
+     * called only if arrays, lights or surfaces have changed */
 
     /* reset surface's trnode/bvnode list */
     srf->top = RT_NULL;
@@ -1849,8 +1913,8 @@ rt_void rt_SceneThread::snode(rt_Surface *srf)
  */
 rt_void rt_SceneThread::sclip(rt_Surface *srf)
 {
-    /* as temporary memory pool is released after every frame,
-     * always rebuild the list even if the scene hasn't changed */
+    /* the list is kept in thread's cache pool across frames,
+     * called only if arrays, lights or surfaces have changed */
 
     /* init surface's relations template */
     rt_ELEM *lst = srf->rel;
@@ -1979,24 +2043,29 @@ rt_void rt_SceneThread::sclip(rt_Surface *srf)
 }
 
 /*
- * Build tile list for a given surface "srf" based
+ * Project tile spans for a given surface "srf" based
  * on the area its projected bbox occupies in the tilebuffer.
  */
 rt_void rt_SceneThread::stile(rt_Surface *srf)
 {
-    /* as temporary memory pool is released after every frame,
-     * always rebuild the list even if the scene hasn't changed */
-
-    srf->tls = RT_NULL;
+    /* the list is kept in surface's tile spans across frames,
+     * bbox is only reprojected if surface's bounds or camera moved,
+     * tile lists are binned from the spans directly in "tsort" */
 
 #if RT_OPTS_TILING != 0
     if ((scene->opts & RT_OPTS_TILING) == 0)
 #endif /* RT_OPTS_TILING */
+    {
+        srf->tlr_min = 0;
+        srf->tlr_max = -1;
+        return;
+    }
+
+    if (srf->srf_changed == 0 && scene->tls_changed == 0)
     {
         return;
     }
 
-    rt_ELEM *elm;
     rt_si32 i, j;
     rt_si32 k;
 
@@ -2133,27 +2202,112 @@ rt_void rt_SceneThread::stile(rt_Surface *srf)
             txmin[i] = 0;
             txmax[i] = scene->tiles_in_row - 1;
         }
+
+        if (RT_IS_PLANE(srf))
+        {
+            ptile(srf);
+        }
     }
 
-    rt_ELEM **ptr = RT_GET_ADR(srf->tls);
+    /* keep tile spans for the next frame */
+    memcpy(srf->tlx, txmin,
+                sizeof(rt_si32) * scene->tiles_in_col);
+    memcpy(srf->tlx + scene->tiles_in_col, txmax,
+                sizeof(rt_si32) * scene->tiles_in_col);
+
+    /* find spans' range of tile-rows, so that
+     * blocks of tile-rows can be binned by separate threads */
+    srf->tlr_min = 0;
+    srf->tlr_max = -1;
 
-    /* fill marked tiles with surface data */
     for (i = 0; i < scene->tiles_in_col; i++)
     {
-        for (j = txmin[i]; j <= txmax[i]; j++)
+        if (txmin[i] > txmax[i])
         {
-            /* alloc new element for each tile of "srf" */
-            elm = (rt_ELEM *)alloc(sizeof(rt_ELEM), RT_QUAD_ALIGN);
-            elm->data = i << 16 | j;
-            elm->simd = srf->s_srf;
-            elm->temp = srf->bvbox;
-            /* insert element as list's tail */
-           *ptr = elm;
-            ptr = &elm->next;
+            continue;
+        }
+
+        if (srf->tlr_min > srf->tlr_max)
+        {
+            srf->tlr_min = i;
         }
+
+        srf->tlr_max = i;
     }
+}
 
-   *ptr = RT_NULL;
+/*
+ * Cull tiles of boundless plane "srf" to those whose rays
+ * head towards the plane from the camera's side (with margin),
+ * as ray's dot with plane's normal is linear across the screen.
+ */
+rt_void rt_SceneThread::ptile(rt_Surface *srf)
+{
+    rt_vec4 vec, nrm, org;
+
+    RT_VEC3_SET(nrm, srf->mtx[RT_K]);
+    RT_VEC3_SET(org, srf->pos);
+
+    /* plane's matrix is relative to its trnode if any */
+    if (srf->trnode != RT_NULL && srf->trnode != srf)
+    {
+        nrm[RT_W] = 0.0f;
+        matrix_mul_vector(vec, srf->trnode->mtx, nrm);
+        RT_VEC3_SET(nrm, vec);
+
+        org[RT_W] = 1.0f;
+        matrix_mul_vector(vec, srf->trnode->mtx, org);
+        RT_VEC3_SET(org, vec);
+    }
+
+    /* camera's side of the plane */
+    RT_VEC3_SUB(vec, scene->pos, org);
+    rt_real dot = RT_VEC3_DOT(vec, nrm);
+
+    if (RT_FABS(dot) <= RT_CLIP_THRESHOLD)
+    {
+        return;
+    }
+
+    /* ray's dot at top-left corner and its steps per tile,
+     * negative if ray heads towards the plane */
+    rt_real d0 = RT_VEC3_DOT(scene->dir, nrm) * dot;
+    rt_real dx = RT_VEC3_DOT(scene->htl, nrm) * dot /
+                 RT_VEC3_DOT(scene->htl, scene->htl);
+    rt_real dy = RT_VEC3_DOT(scene->vtl, nrm) * dot /
+                 RT_VEC3_DOT(scene->vtl, scene->vtl);
+
+    rt_real mx = (rt_real)scene->tiles_in_row;
+    rt_real dm, x0;
+    rt_si32 i;
+
+    for (i = 0; i < scene->tiles_in_col; i++)
+    {
+        /* least dot within tile-row plus one tile on both sides */
+        dm = d0 + RT_MIN(dy * (i - 1), dy * (i + 2));
+
+        if (dx == 0.0f)
+        {
+            if (dm >= 0.0f)
+            {
+                txmin[i] = scene->tiles_in_row;
+                txmax[i] = -1;
+            }
+            continue;
+        }
+
+        /* dot crosses zero at "x0", keep one tile of margin */
+        x0 = RT_MAX(-2.0f, RT_MIN(mx + 1.0f, -dm / dx));
+
+        if (dx > 0.0f)
+        {
+            txmax[i] = RT_MIN(txmax[i], (rt_si32)RT_FLOOR(x0));
+        }
+        else
+        {
+            txmin[i] = RT_MAX(txmin[i], (rt_si32)RT_FLOOR(x0) - 1);
+        }
+    }
 }
 
 /*
@@ -2162,8 +2316,8 @@ rt_void rt_SceneThread::stile(rt_Surface *srf)
  */
 rt_ELEM* rt_SceneThread::ssort(rt_Object *obj)
 {
-    /* as temporary memory pool is released after every frame,
-     * always rebuild the list even if the scene hasn't changed */
+    /* global and surface lists are kept in thread's cache pool,
+     * camera's list is rebuilt every frame in per-frame pool */
 
     rt_Surface *srf = RT_NULL;
     rt_ELEM **pto = RT_NULL;
@@ -2451,6 +2605,15 @@ rt_ELEM* rt_SceneThread::ssort(rt_Object *obj)
         return lst;
     }
 
+#if RT_OPTS_VARRAY_EXT1 != 0
+    if ((scene->opts & RT_OPTS_VARRAY_EXT1) != 0)
+    {
+        stree(pto);
+        stree(pti);
+        stree(&lst);
+    }
+#endif /* RT_OPTS_VARRAY_EXT1 */
+
     if (g_print)
     {
         if (*pto != RT_NULL)
@@ -2484,8 +2647,8 @@ rt_ELEM* rt_SceneThread::ssort(rt_Object *obj)
  */
 rt_ELEM* rt_SceneThread::lsort(rt_Object *obj)
 {
-    /* as temporary memory pool is released after every frame,
-     * always rebuild the list even if the scene hasn't changed */
+    /* the list is kept in thread's cache pool across frames,
+     * called only if arrays, lights or surfaces have changed */
 
     rt_Surface *srf = RT_NULL;
     rt_ELEM **pto = RT_NULL;
@@ -2527,6 +2690,14 @@ rt_ELEM* rt_SceneThread::lsort(rt_Object *obj)
         rt_ELEM **psi = RT_NULL;
         rt_ELEM **psr = RT_NULL;
 
+        /* skip light source if surface's bbox is beyond its range,
+         * no shading or shadow rays are then issued towards it */
+        if (srf != RT_NULL
+        &&  bbox_rang(lgt->bvbox, srf->bvbox, lgt->lgt->atn[0]) == 0)
+        {
+            continue;
+        }
+
 #if RT_OPTS_2SIDED != 0
         if ((scene->opts & RT_OPTS_2SIDED) != 0 && srf != RT_NULL)
         {
@@ -2747,6 +2918,15 @@ rt_ELEM* rt_SceneThread::lsort(rt_Object *obj)
         }
 #endif /* RT_OPTS_INSERT, RT_OPTS_TARRAY, RT_OPTS_VARRAY */
 
+#if RT_OPTS_VARRAY_EXT1 != 0
+        if ((scene->opts & RT_OPTS_VARRAY_EXT1) != 0)
+        {
+            stree(pso);
+            stree(psi);
+            stree(psr);
+        }
+#endif /* RT_OPTS_VARRAY_EXT1 */
+
         if (g_print)
         {
             if (pso != RT_NULL && *pso != RT_NULL)
@@ -2782,421 +2962,437 @@ rt_ELEM* rt_SceneThread::lsort(rt_Object *obj)
 }
 
 /*
- * Deinitialize scene thread.
+ * Get sort key of surface "srf" in the bvnode tree
+ * from its world-space bbox "bnd" along axis "a".
  */
-rt_SceneThread::~rt_SceneThread()
+static
+rt_real tree_key(rt_vec4 *bnd, rt_Surface *srf, rt_si32 a)
 {
-    ASM_DONE(s_inf)
+    return bnd[srf->tree_idx * 2 + 0][a] + bnd[srf->tree_idx * 2 + 1][a];
 }
 
-/******************************************************************************/
-/**********************************   SCENE   *********************************/
-/******************************************************************************/
-
 /*
- * Allocate scene in custom heap.
- * Heap "hp" must be the same object as platform "pfm" in constructor.
+ * Get top-level surface of the global "slist" at element "elm"
+ * if it has a finite bbox to be put in the bvnode tree, RT_NULL otherwise,
+ * array nodes are skipped along with their sub-lists by updating "elm".
  */
-rt_pntr rt_Scene::operator new(size_t size, rt_Heap *hp)
+static
+rt_Surface *tree_surface(rt_ELEM **elm)
 {
-    return hp->obj_alloc(size, RT_ALIGN);
+    rt_Node *nd = (rt_Node *)((rt_BOUND *)(*elm)->temp)->obj;
+
+    if (RT_IS_ARRAY(nd))
+    {
+        *elm = RT_GET_PTR((*elm)->data);
+        return RT_NULL;
+    }
+
+    if (nd->bvbox->rad != 0.0f && nd->bvbox->rad != RT_INF
+    &&  nd->bvbox->verts_num != 0)
+    {
+        return (rt_Surface *)nd;
+    }
+
+    return RT_NULL;
 }
 
 /*
- * Delete scene from custom heap.
+ * Build bvnode tree (BVH) over top-level surfaces of the global "slist"
+ * having finite bboxes, other elements stay out of the tree.
+ * The tree is built along with the lists, if it spans the same surfaces
+ * as in the previous build, its bvnodes are only refit to the bounds
+ * updated in the 2nd phase, keeping the surfaces' order in the tree,
+ * a full split is then done every RT_TREE_REFIT builds. Surface lists
+ * for rfl/rfr and shadows are reordered along the tree in "stree".
  */
-rt_void rt_Scene::operator delete(rt_pntr ptr)
+rt_void rt_SceneThread::btree()
 {
-    ((rt_Scene *)ptr)->pfm->obj_free(ptr);
-}
+    rt_si32 i, j, k = 0, n = 0;
+    rt_Surface *srf;
+    rt_ELEM *elm;
 
-/*
- * Instantiate scene.
- * Can only be called from single (main) thread.
- * Platform "pfm" must be the same object as heap "hp" in custom "new".
- */
-rt_Scene::rt_Scene(rt_SCENE *scn, /* "frame" must be SIMD-aligned or NULL */
-                   rt_si32 x_res, rt_si32 y_res, rt_si32 x_row, rt_ui32 *frame,
-                   rt_Platform *pfm) :
+#if RT_OPTS_VARRAY_EXT1 != 0
+    if ((scene->opts & RT_OPTS_VARRAY_EXT1) == 0)
+#endif /* RT_OPTS_VARRAY_EXT1 */
+    {
+        for (srf = scene->srf_head; srf != RT_NULL; srf = srf->next)
+        {
+            srf->tree_idx = -1;
+        }
 
-    rt_Registry(pfm->f_alloc, pfm->f_free),
-    rt_List<rt_Scene>(RT_NULL)
-{
-    this->pfm = pfm;
+        scene->tree_num = 0;
 
-    pfm->add_scene(this);
+        return;
+    }
 
-    thnum = pfm->thnum;
-    tdata = pfm->tdata;
+    /* count top-level surfaces with finite bboxes,
+     * and how many of them are in the previous tree */
+    for (elm = scene->slist; elm != RT_NULL; elm = elm->next)
+    {
+        srf = tree_surface(&elm);
 
-    thr_num = thnum; /* for registry of object hierarchy */
+        if (srf != RT_NULL)
+        {
+            k += srf->tree_idx >= 0;
+            n++;
+        }
+    }
 
-    f_update = pfm->f_update;
-    f_render = pfm->f_render;
+    rt_bool fit = n == scene->tree_num && k == n
+               && scene->tree_fit < RT_TREE_REFIT;
 
-    this->scn = scn;
+    if (fit)
+    {
+        scene->tree_fit++;
+    }
+    else
+    {
+        for (srf = scene->srf_head; srf != RT_NULL; srf = srf->next)
+        {
+            srf->tree_idx = -1;
+        }
 
-    /* check for locked scene data, not thread safe! (it's ok, not a bug) */
-    if (scn->lock != RT_NULL)
+        scene->tree_num = 0;
+        scene->tree_fit = 0;
+
+        if (n <= RT_TREE_LEAF)
+        {
+            return;
+        }
+
+        for (elm = scene->slist, n = 0; elm != RT_NULL; elm = elm->next)
+        {
+            srf = tree_surface(&elm);
+
+            if (srf != RT_NULL)
+            {
+                srf->tree_idx = n++;
+            }
+        }
+    }
+
+    memset(scene->tree_bvb, 0, sizeof(rt_SIMD_SURFACE *) * n);
+
+    /* world-space bboxes from bbox verts,
+     * as bbox itself is relative to trnode if present */
+    rt_vec4 *bnd = (rt_vec4 *)alloc(sizeof(rt_vec4) * 2 * n, RT_ALIGN);
+
+    for (srf = scene->srf_head; srf != RT_NULL; srf = srf->next)
     {
-        throw rt_Exception("scene data is locked by another instance");
+        if (srf->tree_idx < 0)
+        {
+            continue;
+        }
+
+        rt_BOUND *box = srf->bvbox;
+        rt_real *bmin = bnd[srf->tree_idx * 2 + 0];
+        rt_real *bmax = bnd[srf->tree_idx * 2 + 1];
+
+        RT_VEC3_SET(bmin, box->verts[0].pos);
+        RT_VEC3_SET(bmax, box->verts[0].pos);
+
+        for (j = 1; j < box->verts_num; j++)
+        {
+            RT_VEC3_MIN(bmin, bmin, box->verts[j].pos);
+            RT_VEC3_MAX(bmax, bmax, box->verts[j].pos);
+        }
+
+        scene->tree_srf[srf->tree_idx] = srf;
     }
 
-    /* "x_row", frame's stride (in 32-bit pixels, not bytes!),
-     * can be greater than "x_res", in which case the frame
-     * occupies only a portion (rectangle) of the framebuffer,
-     * or negative, in which case frame starts at the last line
-     * and consecutive lines are located backwards in memory,
-     * "x_row" must contain the whole number of SIMD widths */
-    if (x_res == 0 || y_res == 0 || RT_ABS32(x_row) < x_res)
+    tsplit(bnd, 0, n, 0, fit);
+
+    for (i = 0; i < n && !fit; i++)
     {
-        throw rt_Exception("frambuffer's dimensions are not valid");
+        scene->tree_srf[i]->tree_idx = i;
     }
 
-#if (RT_POINTER - RT_ADDRESS) != 0
+    scene->tree_num = n;
 
-    /* always reallocate frame in custom heap for 64-bit
-     * if 32-bit address range is enabled in makefiles */
-    frame = RT_NULL;
+    /* scratch for reordering "slist" below */
+    tree_elm = (rt_ELEM **)alloc(sizeof(rt_ELEM *) * n, RT_ALIGN);
+    memset(tree_elm, 0, sizeof(rt_ELEM *) * n);
 
-#endif /* (RT_POINTER - RT_ADDRESS) */
+    stree(&scene->slist);
+}
 
-    if (((rt_word)frame & (RT_SIMD_ALIGN - 1)) != 0 || frame == RT_NULL
-    || (RT_ABS32(x_row) & (RT_SIMD_WIDTH - 1)) != 0)
+/*
+ * Split surfaces from "i0" to "i1" (exclusive) in the bvnode tree
+ * at the median of their bbox centers along the longest axis,
+ * every RT_TREE_SPLIT-th level "d" of the splits gets its bvnode
+ * indexed by the split's position (recursive). If "fit" is set
+ * the surfaces keep their order and only the bvnodes are refit.
+ */
+rt_void rt_SceneThread::tsplit(rt_vec4 *bnd, rt_si32 i0, rt_si32 i1, rt_si32 d,
+                               rt_bool fit)
+{
+    if (i1 - i0 <= RT_TREE_LEAF)
     {
-        rt_si32 y_sgn = RT_SIGN(x_row);
-
-        x_row = RT_ABS32(x_row);
-        x_row = ((x_row + RT_SIMD_WIDTH - 1) / RT_SIMD_WIDTH) * RT_SIMD_WIDTH;
+        return;
+    }
 
-        frame = (rt_ui32 *)
-                alloc(x_row * y_res * sizeof(rt_ui32), RT_SIMD_ALIGN);
+    rt_Surface **arr = scene->tree_srf;
+    rt_si32 i, j, k = (i0 + i1) / 2, a;
+    rt_vec4 bmin, bmax, cmin, cmax, dff;
 
-        x_row *= y_sgn;
+    RT_VEC3_SET_VAL1(bmin, +RT_INF);
+    RT_VEC3_SET_VAL1(bmax, -RT_INF);
+    RT_VEC3_SET_VAL1(cmin, +RT_INF);
+    RT_VEC3_SET_VAL1(cmax, -RT_INF);
 
-        if (x_row < 0)
+    for (i = i0; i < i1; i++)
+    {
+        for (a = 0; a < 3; a++)
         {
-            frame += RT_ABS32(x_row) * (y_res - 1);
+            rt_real key = tree_key(bnd, arr[i], a);
+            cmin[a] = RT_MIN(cmin[a], key);
+            cmax[a] = RT_MAX(cmax[a], key);
         }
+
+        RT_VEC3_MIN(bmin, bmin, bnd[arr[i]->tree_idx * 2 + 0]);
+        RT_VEC3_MAX(bmax, bmax, bnd[arr[i]->tree_idx * 2 + 1]);
     }
 
-    memset(frame, 0, x_row * y_res * sizeof(rt_ui32));
+    RT_VEC3_SUB(dff, bmax, bmin);
 
-    /* init framebuffer's dimensions and pointer */
-    this->x_res = x_res;
-    this->y_res = y_res;
-    this->x_row = x_row;
-    this->frame = frame;
+    /* stretch flat ranges to keep bounding volume finite,
+     * the volume stays around the bbox as it grows */
+    rt_real m = RT_MAX(dff[RT_X], RT_MAX(dff[RT_Y], dff[RT_Z])) / 64.0f;
 
-    /* init tilebuffer's dimensions and pointer */
-    tiles_in_row = (x_res + pfm->tile_w - 1) / pfm->tile_w;
-    tiles_in_col = (y_res + pfm->tile_h - 1) / pfm->tile_h;
+    if (d % RT_TREE_SPLIT == 0 && m > 0.0f)
+    {
+        rt_SIMD_SURFACE *s_bvb = scene->tree_box[k];
+        memset(s_bvb, 0, sizeof(rt_SIMD_SURFACE));
+        s_bvb->srf_t[3] = RT_TAG_SURFACE_MAX;
 
-    tiles = (rt_ELEM **)
-            alloc(tiles_in_row * tiles_in_col * sizeof(rt_ELEM *), RT_ALIGN);
+        s_bvb->a_map[RT_I] = RT_X * RT_SIMD_QUADS * 16;
+        s_bvb->a_map[RT_J] = RT_Y * RT_SIMD_QUADS * 16;
+        s_bvb->a_map[RT_K] = RT_Z * RT_SIMD_QUADS * 16;
 
-    memset(tiles, 0, tiles_in_row * tiles_in_col * sizeof(rt_ELEM *));
+        RT_SIMD_SET(s_bvb->d_eps, RT_DEPS_THRESHOLD);
+        RT_SIMD_SET(s_bvb->t_eps, RT_TEPS_THRESHOLD);
 
-    /* init pixel-width, aspect-ratio, ray-depth */
-    factor = 1.0f / (rt_real)x_res;
-    aspect = (rt_real)y_res * factor;
-    depth = RT_MAX(RT_STACK_DEPTH, 0);
-    opts &= ~scn->opts;
+        RT_SIMD_SET(s_bvb->pos_x, (bmin[RT_X] + bmax[RT_X]) * 0.5f);
+        RT_SIMD_SET(s_bvb->pos_y, (bmin[RT_Y] + bmax[RT_Y]) * 0.5f);
+        RT_SIMD_SET(s_bvb->pos_z, (bmin[RT_Z] + bmax[RT_Z]) * 0.5f);
 
-    pseed = RT_NULL;
-    ptr_r = RT_NULL;
-    ptr_g = RT_NULL;
-    ptr_b = RT_NULL;
-
-    if ((opts & RT_OPTS_PT) == 0 || (opts & RT_OPTS_BUFFERS) == 0)
-    {
-        /* alloc framebuffer's color-planes for path-tracer */
-        ptr_r = (rt_real *)
-                alloc(4 * x_row * y_res * sizeof(rt_real), RT_SIMD_ALIGN);
-        ptr_g = (rt_real *)
-                alloc(4 * x_row * y_res * sizeof(rt_real), RT_SIMD_ALIGN);
-        ptr_b = (rt_real *)
-                alloc(4 * x_row * y_res * sizeof(rt_real), RT_SIMD_ALIGN);
+        dff[RT_X] = RT_MAX(dff[RT_X], m);
+        dff[RT_Y] = RT_MAX(dff[RT_Y], m);
+        dff[RT_Z] = RT_MAX(dff[RT_Z], m);
 
-                /* ptr_* is initialized in reset_color() */
-    }
-    if ((opts & RT_OPTS_BUFFERS) == 0)
-    {
-        reset_color();
-    }
-    if ((opts & RT_OPTS_PT) == 0)
-    {
-        /* alloc framebuffer's seed-plane for path-tracer */
-        pseed = (rt_elem *)
-                alloc(4 * x_row * y_res * sizeof(rt_elem), RT_SIMD_ALIGN);
+        RT_SIMD_SET(s_bvb->sci_w, 0.75f); /* unit cube's radius squared */
+        RT_SIMD_SET(s_bvb->sci_x, 1.0f / (dff[RT_X] * dff[RT_X]));
+        RT_SIMD_SET(s_bvb->sci_y, 1.0f / (dff[RT_Y] * dff[RT_Y]));
+        RT_SIMD_SET(s_bvb->sci_z, 1.0f / (dff[RT_Z] * dff[RT_Z]));
 
-                /* pseed is initialized in reset_pseed() */
+        scene->tree_bvb[k] = s_bvb;
     }
 
-    pts_c = 0.0f;
-    pt_on = RT_FALSE;
-
-    fsaa = pfm->fsaa;
-
-    /* instantiate object hierarchy */
-    memset(&rootobj, 0, sizeof(rt_OBJECT));
-
-    rootobj.trm.scl[RT_I] = 1.0f;
-    rootobj.trm.scl[RT_J] = 1.0f;
-    rootobj.trm.scl[RT_K] = 1.0f;
-    rootobj.obj = scn->root;
-
-    if (!RT_IS_ARRAY(&scn->root))
+    if (fit)
     {
-        throw rt_Exception("scene's root is not an array");
-    }
-
-    root = new(this) rt_Array(this, RT_NULL, &rootobj); /* also init "*_num" */
+        tsplit(bnd, i0, k, d + 1, fit);
+        tsplit(bnd, k, i1, d + 1, fit);
 
-    if (cam_head == RT_NULL)
-    {
-        throw rt_Exception("scene doesn't contain camera");
+        return;
     }
 
-    cam = cam_head;
-    cam_idx = 0;
-
-    /* lock scene data, when scene's constructor can no longer fail */
-    scn->lock = this;
-
-    /* create scene threads array */
-    tharr = (rt_SceneThread **)
-            alloc(sizeof(rt_SceneThread *) * thnum, RT_ALIGN);
+    a = cmax[RT_X] - cmin[RT_X] >= cmax[RT_Y] - cmin[RT_Y] ? RT_X : RT_Y;
+    a = cmax[a] - cmin[a] >= cmax[RT_Z] - cmin[RT_Z] ? a : RT_Z;
 
-    rt_si32 i;
+    /* select median in place, smaller keys go to the left */
+    rt_si32 l = i0, r = i1 - 1;
 
-    for (i = 0; i < thnum; i++)
+    while (l < r)
     {
-        tharr[i] = new(this) rt_SceneThread(this, i);
-
-        /* estimate per-frame allocs to reduce system calls per thread */
-        tharr[i]->msize =  /* upper bound per surface for tiling */
-            (tiles_in_row * tiles_in_col + /* plus array nodes list */
-             (arr_num + 2) +     /* plus reflections/refractions */
-             (srf_num + arr_num * 2 + /* plus lights and shadows */
-             (srf_num + arr_num * 2 + 1) * lgt_num) * 2) * /* for both sides */
-            sizeof(rt_ELEM) * (srf_num + thnum - 1) / thnum; /* per thread */
-    }
+        rt_real key = tree_key(bnd, arr[(l + r) / 2], a);
 
-    pending = 0;
-
-    /* init memory pool in the heap for temporary per-frame allocs */
-    mpool = RT_NULL; /* rough estimate for surface relations/templates */
-    msize = ((srf_num + 1) * (srf_num + 1) * 2 + /* plus two surface lists */
-             (srf_num + arr_num * 1) * 2 + /* plus lights and shadows list */
-             (srf_num + arr_num * 2 + 1) * lgt_num + /* plus array nodes */
-             tiles_in_row * tiles_in_col * arr_num) *  /* for tiling */
-            sizeof(rt_ELEM);                        /* for main thread */
+        for (i = l, j = r; i <= j;)
+        {
+            while (tree_key(bnd, arr[i], a) < key)
+            {
+                i++;
+            }
+            while (tree_key(bnd, arr[j], a) > key)
+            {
+                j--;
+            }
+            if (i <= j)
+            {
+                rt_Surface *srf = arr[i];
+                arr[i++] = arr[j];
+                arr[j--] = srf;
+            }
+        }
 
-    /* in the estimates above ("arr_num" * x) depends on whether both
-     * trnode/bvnode are allowed in the list or just one of them,
-     * if the estimates are not accurate the engine should still work,
-     * though not as efficient due to unnecessary allocations per frame
-     * or unused extra memory reservation resulting in larger footprint */
-}
+        if (k <= j)
+        {
+            r = j;
+        }
+        else
+        if (k >= i)
+        {
+            l = i;
+        }
+        else
+        {
+            break;
+        }
+    }
 
-/*
- * Update current camera with given "action" for a given "time".
- */
-rt_void rt_Scene::update(rt_time time, rt_si32 action)
-{
-    cam->update_action(time, action);
+    tsplit(bnd, i0, k, d + 1, fit);
+    tsplit(bnd, k, i1, d + 1, fit);
 }
 
 /*
- * Update backend data structures and render frame for a given "time".
+ * Reorder list "ptr" along the scene's bvnode tree. List's top-level
+ * surfaces found in the tree are moved to the list's tail, where they are
+ * grouped under bvnode elements, which let the backend skip whole ranges
+ * of the list missed by all rays within SIMD, other elements stay in front.
  */
-rt_void rt_Scene::render(rt_time time)
+rt_void rt_SceneThread::stree(rt_ELEM **ptr)
 {
-    rt_si32 i;
+    if (scene->tree_num == 0 || ptr == RT_NULL || *ptr == RT_NULL)
+    {
+        return;
+    }
 
-#if RT_OPTS_UPDATE_EXT0 != 0
-    if ((opts & RT_OPTS_UPDATE_EXT0) == 0 || rootobj.time == -1)
-    { /* -->---->-- skip update1 -->---->-- */
-#endif /* RT_OPTS_UPDATE_EXT0 */
+    rt_si32 i, k = 0;
+    rt_ELEM *elm, *nxt, **pre = ptr;
 
-    if (pending)
+    for (elm = *ptr; elm != RT_NULL; elm = nxt)
     {
-        pending = 0;
+        rt_Node *nd = (rt_Node *)((rt_BOUND *)elm->temp)->obj;
 
-        /* release memory for temporary per-frame allocs */
-        for (i = 0; i < thnum; i++)
+        /* skip array node along with its sub-list */
+        if (RT_IS_ARRAY(nd))
         {
-            tharr[i]->release(tharr[i]->mpool);
+            elm = RT_GET_PTR(elm->data);
+            nxt = elm->next;
+            pre = &elm->next;
+            continue;
         }
 
-        release(mpool);
-    }
+        nxt = elm->next;
+        i = ((rt_Surface *)nd)->tree_idx;
 
-    /* reserve memory for temporary per-frame allocs */
-    mpool = reserve(msize, RT_QUAD_ALIGN);
+        if (i < 0 || tree_elm[i] != RT_NULL)
+        {
+            pre = &elm->next;
+            continue;
+        }
 
-    for (i = 0; i < thnum; i++)
-    {
-        tharr[i]->mpool = tharr[i]->reserve(tharr[i]->msize, RT_QUAD_ALIGN);
+        /* move surface out of the list */
+        tree_elm[i] = elm;
+       *pre = nxt;
+        k++;
     }
 
-    /* print state init */
-    if (g_print)
+    if (k == 0)
     {
-        RT_PRINT_STATE_INIT();
-        RT_PRINT_TIME(time);
+        return;
     }
 
-    /* phase 0.5, hierarchical update of arrays' transform matrices */
-    root->update_object(time, 0, RT_NULL, iden4);
-
-    if (pt_on && (root->scn_changed || pfm->fsaa != fsaa))
-    {
-        reset_color();
-    }
+    elm = tnode(pre, 0, scene->tree_num, 0);
+    elm->next = RT_NULL;
+}
 
-    /* update current antialiasing mode per scene */
-    fsaa = pfm->fsaa;
+/*
+ * Append list's surfaces from the bvnode tree range
+ * from "i0" to "i1" (exclusive) at the list's tail "ptr"
+ * and wrap them into bvnode element if there are two or more.
+ * Return last appended element or NULL if none (recursive).
+ */
+rt_ELEM* rt_SceneThread::tnode(rt_ELEM **ptr, rt_si32 i0, rt_si32 i1, rt_si32 d)
+{
+    rt_ELEM *elm, *lst = RT_NULL;
 
-    /* 1st phase of multi-threaded update */
-#if RT_OPTS_THREAD != 0
-    if ((opts & RT_OPTS_THREAD) != 0 && this == pfm->get_cur_scene() && !g_print
-#if RT_OPTS_UPDATE_EXT1 != 0
-    &&  (opts & RT_OPTS_UPDATE_EXT1) == 0
-#endif /* RT_OPTS_UPDATE_EXT1 */
-       )
-    {
-        this->f_update(tdata, thnum, 1);
-    }
-    else
-#endif /* RT_OPTS_THREAD */
+    if (i1 - i0 <= RT_TREE_LEAF)
     {
-        update_scene(this, -thnum, 1);
-    }
-
-    /* update ray positioning and steppers */
-    rt_real h, v;
-
-    RT_VEC3_SET(pos, cam->pos);
-    RT_VEC3_SET(hor, cam->hor);
-    RT_VEC3_SET(ver, cam->ver);
-    RT_VEC3_SET(nrm, cam->nrm);
-
-    h = -0.5f * 1.0f;
-    v = -0.5f * aspect;
-
-    /* aim rays at camera's top-left corner */
-    RT_VEC3_MUL_VAL1(dir, nrm, cam->pov);
-    RT_VEC3_MAD_VAL1(dir, hor, h);
-    RT_VEC3_MAD_VAL1(dir, ver, v);
-
-    /* update tile positioning and steppers */
-    RT_VEC3_ADD(org, pos, dir);
-
-    h = 1.0f / (factor * pfm->tile_w); /* x_res / tile_w */
-    v = 1.0f / (factor * pfm->tile_h); /* x_res / tile_h */
+        for (; i0 < i1; i0++)
+        {
+            elm = tree_elm[i0];
 
-    RT_VEC3_MUL_VAL1(htl, hor, h);
-    RT_VEC3_MUL_VAL1(vtl, ver, v);
+            if (elm != RT_NULL)
+            {
+                tree_elm[i0] = RT_NULL;
+               *ptr = elm;
+                ptr = &elm->next;
+                lst = elm;
+            }
+        }
 
-    /* 2nd phase of multi-threaded update */
-#if RT_OPTS_THREAD != 0
-    if ((opts & RT_OPTS_THREAD) != 0 && this == pfm->get_cur_scene() && !g_print
-#if RT_OPTS_UPDATE_EXT2 != 0
-    &&  (opts & RT_OPTS_UPDATE_EXT2) == 0
-#endif /* RT_OPTS_UPDATE_EXT2 */
-       )
-    {
-        this->f_update(tdata, thnum, 2);
-    }
-    else
-#endif /* RT_OPTS_THREAD */
-    {
-        update_scene(this, -thnum, 2);
+        return lst;
     }
 
-    /* phase 2.5, hierarchical update of arrays' bounds from surfaces */
-    root->update_bounds();
+    rt_si32 k = (i0 + i1) / 2;
 
-    rt_Surface *srf;
+    elm = tnode(ptr, i0, k, d + 1);
+    lst = tnode(elm != RT_NULL ? &elm->next : ptr, k, i1, d + 1);
+    lst = lst != RT_NULL ? lst : elm;
 
-    /* update surfaces' node lists */
-    for (srf = srf_head; srf != RT_NULL; srf = srf->next)
+    if (lst == RT_NULL || lst == *ptr || scene->tree_bvb[k] == RT_NULL
+    ||  d % RT_TREE_SPLIT != 0)
     {
-        /* rebuild surface's node list (per-surface)
-         * based on transform flags and arrays' bounds */
-        tharr[0]->snode(srf);
+        return lst;
     }
 
-    /* rebuild global hierarchical list */
-    hlist = tharr[0]->ssort(RT_NULL);
-
-    /* rebuild global surface/node list */
-    slist = tharr[0]->ssort(RT_NULL);
-    tharr[0]->filter(RT_NULL, &slist);
+    /* alloc new bvnode element, the backend skips
+     * up to its last element if all rays miss the volume */
+    elm = (rt_ELEM *)alloc(sizeof(rt_ELEM), RT_QUAD_ALIGN);
+    elm->data = (rt_cell)lst | 1; /* node's type (bv) */
+    elm->simd = scene->tree_bvb[k];
+    elm->temp = RT_NULL;
+    elm->next = *ptr;
+   *ptr = elm;
 
-    /* rebuild global light/shadow list,
-     * "slist" is needed inside */
-    llist = tharr[0]->lsort(RT_NULL);
+    return lst;
+}
 
-    /* rebuild camera's surface/node list,
-     * "slist" is needed inside */
-    clist = tharr[0]->ssort(cam);
+/*
+ * Build tile lists for tile-rows from "i0" to "i1" (exclusive)
+ * by binning surfaces' tiles lists in reversed camera's list order,
+ * blocks of tile-rows are independent and binned by separate threads.
+ * Tile lists are emitted directly into one contiguous slab per block
+ * sized by counting first, surfaces' tile spans are only read.
+ */
+rt_void rt_SceneThread::tsort(rt_si32 i0, rt_si32 i1)
+{
+    rt_si32 i, j, k, n, pass, tiles_in_row = scene->tiles_in_row;
+    rt_si32 tiles_in_col = scene->tiles_in_col;
+    rt_ELEM **tiles = scene->tiles;
 
-    if (g_print)
+    if (i0 >= i1)
     {
-        RT_PRINT_GLB();
-        RT_PRINT_SRF_LST(slist);
-        RT_PRINT_LGT_LST(llist);
-        RT_PRINT_CAM(cam);
-        RT_PRINT_SRF_LST(clist);
+        return;
     }
 
-    /* 3rd phase of multi-threaded update */
-#if RT_OPTS_THREAD != 0
-    if ((opts & RT_OPTS_THREAD) != 0 && this == pfm->get_cur_scene() && !g_print
-#if RT_OPTS_UPDATE_EXT3 != 0
-    &&  (opts & RT_OPTS_UPDATE_EXT3) == 0
-#endif /* RT_OPTS_UPDATE_EXT3 */
-       )
-    {
-        this->f_update(tdata, thnum, 3);
-    }
-    else
-#endif /* RT_OPTS_THREAD */
-    {
-        update_scene(this, -thnum, 3);
-    }
+    memset(tiles + i0 * tiles_in_row, 0,
+                    sizeof(rt_ELEM *) * tiles_in_row * (i1 - i0));
 
-    /* screen tiling */
-    rt_si32 tline, j;
+    rt_si32 tline = i0 * tiles_in_row, tnum = tiles_in_row * (i1 - i0);
 
-#if RT_OPTS_TILING != 0
-    if ((opts & RT_OPTS_TILING) != 0)
-    {
-        memset(tiles, 0, sizeof(rt_ELEM *) * tiles_in_row * tiles_in_col);
+    /* per-tile scratch: elements count (then fill position), end of
+     * tile's run in the slab, surface of the trnode group open at tile
+     * list's head and the group's last element (trnode's data) */
+    rt_si32 *pos = (rt_si32 *)alloc(sizeof(rt_si32) * tnum, RT_ALIGN);
+    rt_si32 *lst = (rt_si32 *)alloc(sizeof(rt_si32) * tnum, RT_ALIGN);
+    rt_si32 *grp = (rt_si32 *)alloc(sizeof(rt_si32) * tnum, RT_ALIGN);
+    rt_Surface **opn = (rt_Surface **)
+                    alloc(sizeof(rt_Surface *) * tnum, RT_ALIGN);
 
-        rt_ELEM *elm, *nxt, *ctail = RT_NULL, **ptr = &ctail;
+    memset(pos, 0, sizeof(rt_si32) * tnum);
+    memset(opn, 0, sizeof(rt_Surface *) * tnum);
 
-        /* build exact copy of reversed "clist" (should be cheap),
-         * trnode elements become tailing rather than heading,
-         * elements grouping for cached transform is retained */
-        for (nxt = clist; nxt != RT_NULL; nxt = nxt->next)
-        {
-            /* alloc new element as "nxt's" copy */
-            elm = (rt_ELEM *)alloc(sizeof(rt_ELEM), RT_QUAD_ALIGN);
-            elm->data = nxt->data;
-            elm->simd = nxt->simd;
-            elm->temp = nxt->temp;
-            /* insert element as list's head */
-            elm->next = *ptr;
-           *ptr = elm;
-        }
+    rt_ELEM *elm, *slb = RT_NULL;
 
+    /* 1st pass counts elements per tile (including trnode elements),
+     * 2nd pass fills tiles' runs from their ends backwards, as elements
+     * are inserted as list's head in reversed "clist" order */
+    for (pass = 0; pass < 2; pass++)
+    {
         /* traverse reversed "clist" to keep original "clist's" order
          * and optimize trnode handling for each tile */
-        for (elm = ctail; elm != RT_NULL; elm = elm->next)
+        for (elm = scene->rlist; elm != RT_NULL; elm = elm->next)
         {
             rt_Node *nd = (rt_Node *)((rt_BOUND *)elm->temp)->obj;
 
@@ -3209,193 +3405,1549 @@ rt_void rt_Scene::render(rt_time time)
 
             rt_Surface *srf = (rt_Surface *)nd;
 
-            rt_ELEM *tls = srf->tls, *trn;
+            if (srf->tlr_max < i0 || srf->tlr_min >= i1)
+            {
+                continue;
+            }
+
+            rt_BOUND *trb = RT_NULL;
 
             if (srf->trnode != RT_NULL && srf->trnode != srf)
             {
-                for (; tls != RT_NULL; tls = nxt)
-                {
-                    i = (rt_word)tls->data >> 16;
-                    j = (rt_word)tls->data & 0xFFFF;
+                trb = (rt_BOUND *)srf->trn->temp;
+            }
 
-                    nxt = tls->next;
+            /* only tiles within the block of tile-rows are taken */
+            rt_si32 r0 = RT_MAX(i0, srf->tlr_min);
+            rt_si32 r1 = RT_MIN(i1, srf->tlr_max + 1);
 
-                    tls->data = 0;
+            rt_si32 *tlx = srf->tlx;
 
-                    tline = i * tiles_in_row;
+            for (i = r0; i < r1; i++)
+            {
+                for (j = tlx[i]; j <= tlx[tiles_in_col + i]; j++)
+                {
+                    k = i * tiles_in_row + j - tline;
 
-                    /* check matching existing trnode for insertion,
+                    /* check matching trnode group open at list's head,
                      * only tile list's head needs to be checked as elements
                      * grouping for cached transform is retained from "clist" */
-                    trn = tiles[tline + j];
+                    rt_bool match = opn[k] != RT_NULL
+                                 && (rt_BOUND *)opn[k]->trn->temp == trb;
 
-                    rt_Array *arr = (rt_Array *)srf->trnode;
-                    rt_BOUND *trb = (rt_BOUND *)srf->trn->temp;
+                    if (pass == 0)
+                    {
+                        pos[k] += trb != RT_NULL && !match ? 2 : 1;
+                        opn[k] = trb != RT_NULL ? srf : RT_NULL;
+                        continue;
+                    }
 
-                    if (trn != RT_NULL && trn->temp == trb)
+                    /* close the group with its trnode element
+                     * as the new element doesn't belong to it */
+                    if (opn[k] != RT_NULL && !match)
                     {
-                        /* insert element under existing trnode */
-                        tls->next = trn->next;
-                        trn->next = tls;
+                        tclose(slb, pos, grp, opn, k);
                     }
-                    else
+
+                    /* insert element as list's head (or under its trnode) */
+                    n = --pos[k];
+                    slb[n].data = 0;
+                    slb[n].simd = srf->s_srf;
+                    slb[n].temp = srf->bvbox;
+                    slb[n].next = n + 1 < lst[k] ? &slb[n + 1] : RT_NULL;
+
+                    if (trb != RT_NULL && !match)
                     {
-                        /* insert element as list's head */
-                        tls->next = tiles[tline + j];
-                        tiles[tline + j] = tls;
-
-                        /* alloc new trnode element as none has been found */
-                        trn = (rt_ELEM *)alloc(sizeof(rt_ELEM), RT_QUAD_ALIGN);
-                        trn->data = (rt_cell)tls; /* trnode's last element */
-                        trn->simd = arr->s_srf;
-                        trn->temp = trb;
-                        /* insert element as list's head */
-                        trn->next = tiles[tline + j];
-                        tiles[tline + j] = trn;
+                        opn[k] = srf;
+                        grp[k] = n;
                     }
                 }
             }
-            else
-            {
-                for (; tls != RT_NULL; tls = nxt)
-                {
-                    i = (rt_word)tls->data >> 16;
-                    j = (rt_word)tls->data & 0xFFFF;
-
-                    nxt = tls->next;
-
-                    tls->data = 0;
+        }
 
-                    tline = i * tiles_in_row;
+        if (pass != 0)
+        {
+            break;
+        }
+
+        /* lay tiles' runs out in the slab in tile order */
+        for (k = 0, n = 0; k < tnum; k++)
+        {
+            n += pos[k];
+            lst[k] = n;
+        }
+
+        if (n == 0)
+        {
+            return;
+        }
+
+        slb = (rt_ELEM *)alloc(sizeof(rt_ELEM) * n, RT_QUAD_ALIGN);
+
+        for (k = 0; k < tnum; k++)
+        {
+            tiles[tline + k] = pos[k] != 0 ? &slb[lst[k] - pos[k]] : RT_NULL;
+            pos[k] = lst[k];
+            opn[k] = RT_NULL;
+        }
+    }
+
+    /* close groups left open at tile lists' heads */
+    for (k = 0; k < tnum; k++)
+    {
+        if (opn[k] != RT_NULL)
+        {
+            tclose(slb, pos, grp, opn, k);
+        }
+    }
+}
+
+/*
+ * Close trnode group open at the head of tile "k" by placing its
+ * trnode element in front of the group within tile's run in "slb".
+ */
+rt_void rt_SceneThread::tclose(rt_ELEM *slb, rt_si32 *pos, rt_si32 *grp,
+                               rt_Surface **opn, rt_si32 k)
+{
+    rt_si32 n = --pos[k];
+
+    slb[n].data = (rt_cell)&slb[grp[k]]; /* trnode's last element */
+    slb[n].simd = ((rt_Array *)opn[k]->trnode)->s_srf;
+    slb[n].temp = opn[k]->trn->temp;
+    slb[n].next = &slb[n + 1];
+
+    opn[k] = RT_NULL;
+}
+
+/* size of SIMD-buffers for "n" slots,
+ * padded with a cache line on both sides */
+#define RT_BUFFER_ALLOC(n)                                                  \
+        (RT_BUFFER_POOL * (n) + RT_SIMD_ALIGN + RT_CACHE_LINE * 2)
+
+/*
+ * Grow thread's SIMD-buffers to fit "num" slots,
+ * new buffers are reset as buffers' counters expect.
+ */
+rt_void rt_SceneThread::grow_bufs(rt_si32 num)
+{
+    if (bfr_num >= num)
+    {
+#if 0 /* SIMD-buffers don't normally require reset between frames */
+        memset(s_inf->bfr_p, 255, RT_BUFFER_POOL * bfr_num);
+#endif /* enable for SIMD-buffers as a debug option if needed */
+        return;
+    }
+
+    if (bfr_p != RT_NULL)
+    {
+        f_free(bfr_p, RT_BUFFER_ALLOC(bfr_num));
+    }
+
+    /* grow geometrically as surfaces get their slots gradually */
+    bfr_num = RT_MAX(num, bfr_num * 2);
+
+    bfr_p = f_alloc(RT_BUFFER_ALLOC(bfr_num));
+
+    /* check for out of memory */
+    if (bfr_p == RT_NULL)
+    {
+        bfr_num = 0;
+        throw rt_Exception("out of memory in grow_bufs");
+    }
+
+    s_inf->bfr_p = (rt_pntr)(((rt_word)bfr_p + RT_CACHE_LINE +
+                              (RT_SIMD_ALIGN - 1)) & ~(RT_SIMD_ALIGN - 1));
+
+    memset(s_inf->bfr_p, 255, RT_BUFFER_POOL * bfr_num);
+}
+
+/*
+ * Deinitialize scene thread.
+ */
+rt_SceneThread::~rt_SceneThread()
+{
+    if (bfr_p != RT_NULL)
+    {
+        f_free(bfr_p, RT_BUFFER_ALLOC(bfr_num));
+    }
+
+    ASM_DONE(s_inf)
+}
+
+/******************************************************************************/
+/**********************************   SCENE   *********************************/
+/******************************************************************************/
+
+/*
+ * Async render state, "pool" - single-thread pool rendering
+ * posted frames in order (fence is frame's job number in the pool),
+ * "sub" - number of frames submitted.
+ */
+struct rt_SceneAsync
+{
+    rt_ThreadPool          *pool;
+
+    rt_si32                 sub;
+};
+
+/*
+ * Async render slice, run by the single thread of scene's async pool
+ * for the frame with a given "fence".
+ */
+static
+rt_void slice_async(rt_pntr data, rt_si32 index, rt_si32 fence)
+{
+    ((rt_Scene *)data)->run_async(fence);
+}
+
+/*
+ * Allocate scene in custom heap.
+ * Heap "hp" must be the same object as platform "pfm" in constructor.
+ */
+rt_pntr rt_Scene::operator new(size_t size, rt_Heap *hp)
+{
+    return hp->obj_alloc(size, RT_ALIGN);
+}
+
+/*
+ * Delete scene from custom heap.
+ */
+rt_void rt_Scene::operator delete(rt_pntr ptr)
+{
+    ((rt_Scene *)ptr)->pfm->obj_free(ptr);
+}
+
+/*
+ * Instantiate scene.
+ * Can only be called from single (main) thread.
+ * Platform "pfm" must be the same object as heap "hp" in custom "new".
+ */
+rt_Scene::rt_Scene(rt_SCENE *scn, /* "frame" must be SIMD-aligned or NULL */
+                   rt_si32 x_res, rt_si32 y_res, rt_si32 x_row, rt_ui32 *frame,
+                   rt_Platform *pfm) :
+
+    rt_Registry(pfm->f_alloc, pfm->f_free),
+    rt_List<rt_Scene>(RT_NULL)
+{
+    this->pfm = pfm;
+
+    pfm->add_scene(this);
+
+    thnum = pfm->thnum;
+    tdata = pfm->tdata;
+
+    thr_num = thnum; /* for registry of object hierarchy */
+
+    f_update = pfm->f_update;
+    f_render = pfm->f_render;
+
+    this->scn = scn;
+
+    /* check for locked scene data, not thread safe! (it's ok, not a bug) */
+    if (scn->lock != RT_NULL)
+    {
+        throw rt_Exception("scene data is locked by another instance");
+    }
+
+    /* "x_row", frame's stride (in 32-bit pixels, not bytes!),
+     * can be greater than "x_res", in which case the frame
+     * occupies only a portion (rectangle) of the framebuffer,
+     * or negative, in which case frame starts at the last line
+     * and consecutive lines are located backwards in memory,
+     * "x_row" must contain the whole number of SIMD widths */
+    if (x_res == 0 || y_res == 0 || RT_ABS32(x_row) < x_res)
+    {
+        throw rt_Exception("frambuffer's dimensions are not valid");
+    }
+
+#if (RT_POINTER - RT_ADDRESS) != 0
+
+    /* always reallocate frame in custom heap for 64-bit
+     * if 32-bit address range is enabled in makefiles */
+    frame = RT_NULL;
+
+#endif /* (RT_POINTER - RT_ADDRESS) */
+
+    if (((rt_word)frame & (RT_SIMD_ALIGN - 1)) != 0 || frame == RT_NULL
+    || (RT_ABS32(x_row) & (RT_SIMD_WIDTH - 1)) != 0)
+    {
+        rt_si32 y_sgn = RT_SIGN(x_row);
+
+        x_row = RT_ABS32(x_row);
+        x_row = ((x_row + RT_SIMD_WIDTH - 1) / RT_SIMD_WIDTH) * RT_SIMD_WIDTH;
+
+        frame = (rt_ui32 *)
+                alloc(x_row * y_res * sizeof(rt_ui32), RT_SIMD_ALIGN);
+
+        x_row *= y_sgn;
+
+        if (x_row < 0)
+        {
+            frame += RT_ABS32(x_row) * (y_res - 1);
+        }
+    }
+
+    /* frame is zeroed per tile-row block in the first-touch phase below */
+
+    /* init framebuffer's dimensions and pointer */
+    this->x_res = x_res;
+    this->y_res = y_res;
+    this->x_row = x_row;
+    this->frame = frame;
+
+    /* init tilebuffer's dimensions and pointer */
+    tiles_in_row = (x_res + pfm->tile_w - 1) / pfm->tile_w;
+    tiles_in_col = (y_res + pfm->tile_h - 1) / pfm->tile_h;
+
+    tiles = (rt_ELEM **)
+            alloc(tiles_in_row * tiles_in_col * sizeof(rt_ELEM *), RT_ALIGN);
+
+    memset(tiles, 0, tiles_in_row * tiles_in_col * sizeof(rt_ELEM *));
+
+    srfs_taken = 0;
+    subs_taken = 0;
+    subs_t = 0;
+
+    /* init pixel-width, aspect-ratio, ray-depth */
+    factor = 1.0f / (rt_real)x_res;
+    aspect = (rt_real)y_res * factor;
+    depth = RT_MAX(RT_STACK_DEPTH, 0);
+    opts &= ~scn->opts;
+
+    pseed = RT_NULL;
+    ptr_r = RT_NULL;
+    ptr_g = RT_NULL;
+    ptr_b = RT_NULL;
+
+    if ((opts & RT_OPTS_PT) == 0 || (opts & RT_OPTS_BUFFERS) == 0)
+    {
+        /* alloc framebuffer's color-planes for path-tracer */
+        ptr_r = (rt_real *)
+                alloc(4 * x_row * y_res * sizeof(rt_real), RT_SIMD_ALIGN);
+        ptr_g = (rt_real *)
+                alloc(4 * x_row * y_res * sizeof(rt_real), RT_SIMD_ALIGN);
+        ptr_b = (rt_real *)
+                alloc(4 * x_row * y_res * sizeof(rt_real), RT_SIMD_ALIGN);
+
+                /* ptr_* is zeroed in the first-touch phase below */
+    }
+    if ((opts & RT_OPTS_PT) == 0)
+    {
+        /* alloc framebuffer's seed-plane for path-tracer */
+        pseed = (rt_elem *)
+                alloc(4 * x_row * y_res * sizeof(rt_elem), RT_SIMD_ALIGN);
+
+                /* pseed is initialized in reset_pseed() */
+    }
+
+    pts_c = 0.0f;
+    pt_on = RT_FALSE;
+
+    fsaa = pfm->fsaa;
+
+    /* instantiate object hierarchy */
+    memset(&rootobj, 0, sizeof(rt_OBJECT));
+
+    rootobj.trm.scl[RT_I] = 1.0f;
+    rootobj.trm.scl[RT_J] = 1.0f;
+    rootobj.trm.scl[RT_K] = 1.0f;
+    rootobj.obj = scn->root;
+
+    if (!RT_IS_ARRAY(&scn->root))
+    {
+        throw rt_Exception("scene's root is not an array");
+    }
+
+    root = new(this) rt_Array(this, RT_NULL, &rootobj); /* also init "*_num" */
+
+    if (cam_head == RT_NULL)
+    {
+        throw rt_Exception("scene doesn't contain camera");
+    }
+
+    cam = cam_head;
+    cam_idx = 0;
+
+    /* lock scene data, when scene's constructor can no longer fail */
+    scn->lock = this;
+
+    /* create scene threads array */
+    tharr = (rt_SceneThread **)
+            alloc(sizeof(rt_SceneThread *) * thnum, RT_ALIGN);
+
+    rt_si32 i;
+
+    for (i = 0; i < thnum; i++)
+    {
+        tharr[i] = new(this) rt_SceneThread(this, i);
+
+        /* estimate per-frame allocs to reduce system calls per thread */
+        tharr[i]->msize =  /* upper bound per surface for tiling */
+            (tiles_in_row * tiles_in_col + /* plus array nodes list */
+             (arr_num + 2) +     /* plus reflections/refractions */
+             (srf_num + arr_num * 2 + /* plus lights and shadows */
+             (srf_num + arr_num * 2 + 1) * lgt_num) * 2) * /* for both sides */
+            sizeof(rt_ELEM) * (srf_num + thnum - 1) / thnum; /* per thread */
+    }
+
+    /* split the hierarchy into sub-trees for phases 0.5 and 2.5 */
+    init_subs();
+
+    /* alloc surfaces' tile spans kept across frames */
+    rt_Surface *srf;
+
+    for (srf = srf_head; srf != RT_NULL; srf = srf->next)
+    {
+        srf->tlx = (rt_si32 *)
+                alloc(sizeof(rt_si32) * tiles_in_col * 2, RT_ALIGN);
+    }
+
+    /* first-touch phase, each thread zeroes the framebuffer's rows
+     * it renders and pre-faults its per-frame pool, so that pages are
+     * placed on thread's NUMA node with first-touch policy of the OS */
+#if RT_OPTS_THREAD != 0
+    if ((opts & RT_OPTS_THREAD) != 0)
+    {
+        this->f_render(tdata, this, thnum, 0);
+    }
+    else
+#endif /* RT_OPTS_THREAD */
+    {
+        render_scene(pfm, this, thnum, 0);
+    }
+
+    pending = 0;
+    rebuild = 1;
+    lst_looks = 0;
+    lst_hits = 0;
+    tls_changed = 1;
+    tls_cam = RT_NULL;
+    /* slot 0 is reserved for nodes without slots of their own
+     * (arrays and surfaces not reachable by rays), it is never
+     * written and stays reset, so flushing it is a no-op */
+    bfr_num = 1;
+
+    tree_num = 0;
+    tree_fit = 0;
+    tree_srf = RT_NULL;
+    tree_bvb = RT_NULL;
+    tree_box = RT_NULL;
+
+    /* alloc bvnode tree kept across frames, which lets animated
+     * frames refit its bvnodes in place as the lists get rebuilt,
+     * a bvnode can take any index from the surfaces' range */
+    if (srf_num > RT_TREE_LEAF)
+    {
+        tree_srf = (rt_Surface **)
+                alloc(sizeof(rt_Surface *) * srf_num, RT_ALIGN);
+        tree_bvb = (rt_SIMD_SURFACE **)
+                alloc(sizeof(rt_SIMD_SURFACE *) * srf_num, RT_ALIGN);
+        tree_box = (rt_SIMD_SURFACE **)
+                alloc(sizeof(rt_SIMD_SURFACE *) * srf_num, RT_ALIGN);
+
+        for (i = 0; i < srf_num; i++)
+        {
+            tree_box[i] = (rt_SIMD_SURFACE *)
+                alloc(sizeof(rt_SIMD_SURFACE), RT_SIMD_ALIGN);
+        }
+    }
+
+    pipe_on = 0;
+    piped = 0;
+    pipe_t = 0;
+
+    ring = RT_NULL;
+    ring_t = RT_NULL;
+    ring_e = RT_NULL;
+    ring_num = 0;
+    ring_max = 0;
+    async = RT_NULL;
+
+    /* init memory pool in the heap for temporary per-frame allocs */
+    mpool = RT_NULL; /* rough estimate for surface relations/templates */
+    msize = ((srf_num + 1) * (srf_num + 1) * 2 + /* plus two surface lists */
+             (srf_num + arr_num * 1) * 2 + /* plus lights and shadows list */
+             (srf_num + arr_num * 2 + 1) * lgt_num + /* plus array nodes */
+             tiles_in_row * tiles_in_col * arr_num) *  /* for tiling */
+            sizeof(rt_ELEM);                        /* for main thread */
+
+    /* in the estimates above ("arr_num" * x) depends on whether both
+     * trnode/bvnode are allowed in the list or just one of them,
+     * if the estimates are not accurate the engine should still work,
+     * though not as efficient due to unnecessary allocations per frame
+     * or unused extra memory reservation resulting in larger footprint */
+}
+
+/*
+ * Update current camera with given "action" for a given "time".
+ */
+rt_void rt_Scene::update(rt_time time, rt_si32 action)
+{
+    cam->update_action(time, action);
+}
+
+/*
+ * Update backend data structures and render frame for a given "time".
+ */
+rt_void rt_Scene::render(rt_time time)
+{
+    rt_si32 i;
+
+    rt_bool pipe = RT_FALSE, done = RT_FALSE, subs = RT_FALSE;
+
+#if RT_OPTS_THREAD != 0
+    if (sub_num > 0 && (opts & RT_OPTS_THREAD) != 0
+    &&  !g_print)
+    {
+        subs = RT_TRUE;
+    }
+#endif /* RT_OPTS_THREAD */
+
+#if RT_OPTS_THREAD != 0
+    if (pipe_on != 0 && (opts & RT_OPTS_THREAD) != 0
+    &&  async == RT_NULL && !g_print
+#if RT_OPTS_UPDATE_EXT0 != 0
+    &&  (opts & RT_OPTS_UPDATE_EXT0) == 0
+#endif /* RT_OPTS_UPDATE_EXT0 */
+#if RT_OPTS_RENDER_EXT0 != 0
+    &&  (opts & RT_OPTS_RENDER_EXT0) == 0
+#endif /* RT_OPTS_RENDER_EXT0 */
+#if RT_OPTS_RENDER_EXT1 != 0
+    &&  (opts & RT_OPTS_RENDER_EXT1) == 0
+#endif /* RT_OPTS_RENDER_EXT1 */
+       )
+    {
+        pipe = RT_TRUE;
+    }
+#endif /* RT_OPTS_THREAD */
+
+    if (piped)
+    {
+        piped = 0;
+
+        /* render the frame updated by the previous call,
+         * while thread 0 runs phase 0.5 for the current "time" */
+        if (pipe)
+        {
+            pipe_t = time;
+
+            /* reset tile-rows counters */
+            reset_rows();
+
+            this->f_render(tdata, this, thnum, 2);
+
+            pts_c = tharr[0]->s_inf->pts_c[0];
+
+            done = RT_TRUE;
+        }
+
+        /* release memory for temporary per-frame allocs,
+         * lagged frame is dropped if pipelining is no longer possible */
+        release_pools();
+    }
+
+#if RT_OPTS_UPDATE_EXT0 != 0
+    if ((opts & RT_OPTS_UPDATE_EXT0) == 0 || rootobj.time == -1)
+    { /* -->---->-- skip update1 -->---->-- */
+#endif /* RT_OPTS_UPDATE_EXT0 */
+
+    if (pending)
+    {
+        pending = 0;
+
+        /* release memory for temporary per-frame allocs */
+        release_pools();
+    }
+
+    /* reserve memory for temporary per-frame allocs,
+     * threads' pools are reserved along with lists' check below */
+    mpool = reserve(msize, RT_QUAD_ALIGN);
+
+    /* print state init */
+    if (g_print)
+    {
+        RT_PRINT_STATE_INIT();
+        RT_PRINT_TIME(time);
+    }
+
+    /* phase 0.5, hierarchical update of arrays' transform matrices,
+     * already done in pipelined render of the previous frame if "done" */
+    if (!done && subs)
+    {
+        /* update top arrays' heads sequentially (parents first) */
+        root->update_head(time, 0, RT_NULL, iden4);
+
+        for (i = 1; i < top_num; i++)
+        {
+            ((rt_Array *)top_arr[i]->parent)->update_child(time,
+                                                top_arr[i], RT_FALSE);
+        }
+
+        /* call animators sequentially, as object instances
+         * sharing scene data may end up in different sub-trees */
+        rt_Camera  *cam;
+        rt_Light   *lgt;
+        rt_Array   *arr;
+        rt_Surface *srf;
+
+        for (cam = cam_head; cam != RT_NULL; cam = cam->next)
+        {
+            cam->update_anim(time);
+        }
+        for (lgt = lgt_head; lgt != RT_NULL; lgt = lgt->next)
+        {
+            lgt->update_anim(time);
+        }
+        for (arr = arr_head; arr != RT_NULL; arr = arr->next)
+        {
+            arr->update_anim(time);
+        }
+        for (srf = srf_head; srf != RT_NULL; srf = srf->next)
+        {
+            srf->update_anim(time);
+        }
+
+        /* reset sub-trees counter */
+        subs_t = time;
+        subs_taken = 0;
+
+        /* update sub-trees in parallel */
+        this->f_update(tdata, this, thnum, 4);
+
+        /* update top arrays' changed status (children first) */
+        for (i = top_num - 1; i >= 0; i--)
+        {
+            top_arr[i]->update_tail();
+        }
+    }
+    else
+    if (!done)
+    {
+        root->update_object(time, 0, RT_NULL, iden4);
+    }
+
+    /* check if lists from the cache pools can be kept
+     * based on changed status updated in phase 0.5 */
+    reset_lists();
+
+    if (pt_on && (root->scn_changed || pfm->fsaa != fsaa))
+    {
+        reset_color();
+    }
+
+    /* update current antialiasing mode per scene */
+    fsaa = pfm->fsaa;
+
+    /* 1st phase of multi-threaded update */
+#if RT_OPTS_THREAD != 0
+    if ((opts & RT_OPTS_THREAD) != 0 && !g_print
+#if RT_OPTS_UPDATE_EXT1 != 0
+    &&  (opts & RT_OPTS_UPDATE_EXT1) == 0
+#endif /* RT_OPTS_UPDATE_EXT1 */
+       )
+    {
+        this->f_update(tdata, this, thnum, 1);
+    }
+    else
+#endif /* RT_OPTS_THREAD */
+    {
+        update_scene(pfm, this, thnum, 1);
+    }
+
+    /* update ray positioning and steppers */
+    rt_real h, v;
+
+    RT_VEC3_SET(pos, cam->pos);
+    RT_VEC3_SET(hor, cam->hor);
+    RT_VEC3_SET(ver, cam->ver);
+    RT_VEC3_SET(nrm, cam->nrm);
+
+    h = -0.5f * 1.0f;
+    v = -0.5f * aspect;
+
+    pov = cam->pov;
+
+    /* aim rays at camera's top-left corner */
+    RT_VEC3_MUL_VAL1(dir, nrm, pov);
+    RT_VEC3_MAD_VAL1(dir, hor, h);
+    RT_VEC3_MAD_VAL1(dir, ver, v);
+
+    /* update tile positioning and steppers */
+    RT_VEC3_ADD(org, pos, dir);
+
+    h = 1.0f / (factor * pfm->tile_w); /* x_res / tile_w */
+    v = 1.0f / (factor * pfm->tile_h); /* x_res / tile_h */
+
+    RT_VEC3_MUL_VAL1(htl, hor, h);
+    RT_VEC3_MUL_VAL1(vtl, ver, v);
+
+    /* surfaces' tile spans are only reprojected if their bounds
+     * or camera's tile positioning have changed since last frame,
+     * camera's change invalidates spans of all surfaces at once,
+     * as every projected bbox vertex depends on all of the fields
+     * compared below, so any per-surface test for whether its span
+     * has moved would cost as much as reprojecting its bbox */
+    tls_changed = g_print || tls_cam != cam
+        || memcmp(tls_pos, pos, sizeof(rt_real) * 3) != 0
+        || memcmp(tls_dir, dir, sizeof(rt_real) * 3) != 0
+        || memcmp(tls_nrm, nrm, sizeof(rt_real) * 3) != 0
+        || memcmp(tls_htl, htl, sizeof(rt_real) * 3) != 0
+        || memcmp(tls_vtl, vtl, sizeof(rt_real) * 3) != 0;
+
+    /* spans are not maintained while tiling is off,
+     * force reprojection once it is turned back on */
+    tls_cam = RT_NULL;
+#if RT_OPTS_TILING != 0
+    if ((opts & RT_OPTS_TILING) != 0)
+    {
+        tls_cam = cam;
+    }
+#endif /* RT_OPTS_TILING */
+
+    RT_VEC3_SET(tls_pos, pos);
+    RT_VEC3_SET(tls_dir, dir);
+    RT_VEC3_SET(tls_nrm, nrm);
+    RT_VEC3_SET(tls_htl, htl);
+    RT_VEC3_SET(tls_vtl, vtl);
+
+    /* reset surface-chunks counter */
+    srfs_taken = 0;
+
+    /* 2nd phase of multi-threaded update */
+#if RT_OPTS_THREAD != 0
+    if ((opts & RT_OPTS_THREAD) != 0 && !g_print
+#if RT_OPTS_UPDATE_EXT2 != 0
+    &&  (opts & RT_OPTS_UPDATE_EXT2) == 0
+#endif /* RT_OPTS_UPDATE_EXT2 */
+       )
+    {
+        this->f_update(tdata, this, thnum, 2);
+    }
+    else
+#endif /* RT_OPTS_THREAD */
+    {
+        update_scene(pfm, this, thnum, 2);
+    }
+
+    /* phase 2.5, hierarchical update of arrays' bounds from surfaces,
+     * self-contained sub-trees are updated in parallel beforehand */
+    if (subs)
+    {
+        /* reset sub-trees counter */
+        subs_taken = 0;
+
+        this->f_update(tdata, this, thnum, 5);
+    }
+
+    root->update_bounds();
+
+    if (subs)
+    {
+        for (i = 0; i < sub_num; i++)
+        {
+            if (RT_IS_ARRAY(sub_arr[i]))
+            {
+                ((rt_Array *)sub_arr[i])->bnd_done = 0;
+            }
+        }
+    }
+
+    /* reset surface-chunks counter */
+    srfs_taken = 0;
+
+    /* update surfaces' node lists (multi-threaded),
+     * then rebuild global lists in two independent chains */
+#if RT_OPTS_THREAD != 0
+    if ((opts & RT_OPTS_THREAD) != 0 && !g_print
+#if RT_OPTS_UPDATE_EXT3 != 0
+    &&  (opts & RT_OPTS_UPDATE_EXT3) == 0
+#endif /* RT_OPTS_UPDATE_EXT3 */
+       )
+    {
+        if (rebuild)
+        {
+            this->f_update(tdata, this, thnum, 6);
+        }
+        this->f_update(tdata, this, thnum, 7);
+    }
+    else
+#endif /* RT_OPTS_THREAD */
+    {
+        if (rebuild)
+        {
+            update_scene(pfm, this, thnum, 6);
+        }
+        update_scene(pfm, this, thnum, 7);
+    }
+
+    if (g_print)
+    {
+        RT_PRINT_GLB();
+        RT_PRINT_SRF_LST(slist);
+        RT_PRINT_LGT_LST(llist);
+        RT_PRINT_CAM(cam);
+        RT_PRINT_SRF_LST(clist);
+    }
+
+    /* assign SIMD-buffers slots to surfaces
+     * which can receive rays in this frame */
+    reset_bufs();
+
+    /* reset surface-chunks counter */
+    srfs_taken = 0;
+
+    /* 3rd phase of multi-threaded update */
+#if RT_OPTS_THREAD != 0
+    if ((opts & RT_OPTS_THREAD) != 0 && !g_print
+#if RT_OPTS_UPDATE_EXT3 != 0
+    &&  (opts & RT_OPTS_UPDATE_EXT3) == 0
+#endif /* RT_OPTS_UPDATE_EXT3 */
+       )
+    {
+        this->f_update(tdata, this, thnum, 3);
+    }
+    else
+#endif /* RT_OPTS_THREAD */
+    {
+        update_scene(pfm, this, thnum, 3);
+    }
+
+#if RT_DEBUG >= 1
+    /* threads' SIMD-buffers may have grown in 3rd phase above */
+    check_lines();
+#endif /* RT_DEBUG >= 1 */
+
+    /* screen tiling */
+    rt_si32 tline, j;
+
+#if RT_OPTS_TILING != 0
+    if ((opts & RT_OPTS_TILING) != 0)
+    {
+        /* tile lists are built per block of tile-rows
+         * by each thread at the end of 3rd phase above */
+
+        if (g_print)
+        {
+            rt_si32 i = 0, j = 0;
+
+            tline = i * tiles_in_row;
+
+            RT_PRINT_TLS_LST(tiles[tline + j], i, j);
+        }
+    }
+    else
+#endif /* RT_OPTS_TILING */
+    {
+        for (i = 0; i < tiles_in_col; i++)
+        {
+            tline = i * tiles_in_row;
+
+            for (j = 0; j < tiles_in_row; j++)
+            {
+                tiles[tline + j] = clist;
+            }
+        }
+    }
+
+    /* aim rays at pixel centers */
+    RT_VEC3_MUL_VAL1(hor, hor, factor);
+    RT_VEC3_MUL_VAL1(ver, ver, factor);
+
+    RT_VEC3_MAD_VAL1(dir, hor, 0.5f);
+    RT_VEC3_MAD_VAL1(dir, ver, 0.5f);
+
+    /* accumulate ambient from camera and all light sources */
+    RT_VEC3_MUL_VAL1(amb, cam->cam->col.hdr, cam->cam->lum[0]);
+    amb[RT_A] = cam->cam->lum[0];
+
+    rt_Light *lgt = RT_NULL;
+
+    for (lgt = lgt_head; lgt != RT_NULL; lgt = lgt->next)
+    {
+        RT_VEC3_MAD_VAL1(amb, lgt->lgt->col.hdr, lgt->lgt->lum[0]);
+        amb[RT_A] += lgt->lgt->lum[0];
+    }
+
+#if RT_OPTS_UPDATE_EXT0 != 0
+    } /* --<----<-- skip update1 --<----<-- */
+#endif /* RT_OPTS_UPDATE_EXT0 */
+
+    /* in pipelined mode keep the lists and tiles
+     * until the frame is rendered by the next call */
+    if (pipe)
+    {
+        piped = 1;
+        return;
+    }
+
+
+#if RT_OPTS_RENDER_EXT0 != 0
+    if ((opts & RT_OPTS_RENDER_EXT0) == 0)
+    { /* -->---->-- skip render0 -->---->-- */
+#endif /* RT_OPTS_RENDER_EXT0 */
+
+#if 0 /* SIMD-buffers don't normally require reset between frames */
+    reset_color();
+#endif /* enable for SIMD-buffers as a debug option if needed */
+
+    /* reset tile-rows counters */
+    reset_rows();
+
+    /* multi-threaded render */
+#if RT_OPTS_THREAD != 0
+    if ((opts & RT_OPTS_THREAD) != 0
+#if RT_OPTS_RENDER_EXT1 != 0
+    &&  (opts & RT_OPTS_RENDER_EXT1) == 0
+#endif /* RT_OPTS_RENDER_EXT1 */
+       )
+    {
+        this->f_render(tdata, this, thnum, 1);
+    }
+    else
+#endif /* RT_OPTS_THREAD */
+    {
+        render_scene(pfm, this, thnum, 1);
+    }
+
+    pts_c = tharr[0]->s_inf->pts_c[0];
+
+#if RT_OPTS_RENDER_EXT0 != 0
+    } /* --<----<-- skip render0 --<----<-- */
+#endif /* RT_OPTS_RENDER_EXT0 */
+
+
+#if RT_OPTS_UPDATE_EXT0 != 0
+    if ((opts & RT_OPTS_UPDATE_EXT0) == 0)
+    { /* -->---->-- skip update2 -->---->-- */
+#endif /* RT_OPTS_UPDATE_EXT0 */
+
+    /* print state done */
+    if (g_print)
+    {
+        RT_PRINT_STATE_DONE();
+        g_print = RT_FALSE;
+    }
+
+    /* release memory for temporary per-frame allocs */
+    release_pools();
+
+#if RT_OPTS_UPDATE_EXT0 != 0
+    } /* --<----<-- skip update2 --<----<-- */
+    else
+    {
+        pending = 1;
+    }
+#endif /* RT_OPTS_UPDATE_EXT0 */
+}
+
+/*
+ * Check if surface at position "i" in the list is updated by thread "index"
+ * in the current phase, "n" holds the start of thread's last claimed chunk.
+ */
+rt_bool rt_Scene::srf_slice(rt_si32 index, rt_si32 i, rt_si32 *n)
+{
+#if RT_OPTS_THREAD_EXT2 != 0
+    /* threads pull chunks of surfaces from the shared counter,
+     * as chunks are claimed in order, the list is walked only once */
+    if ((opts & RT_OPTS_THREAD_EXT2) != 0)
+    {
+        if (i >= *n + RT_SRF_CHUNK)
+        {
+           *n = RT_ATOMIC_ADD(&srfs_taken, RT_SRF_CHUNK);
+        }
+
+        return i >= *n;
+    }
+#endif /* RT_OPTS_THREAD_EXT2 */
+
+    return (i % thnum) == index;
+}
+
+/*
+ * Claim next tile-row to render by thread "index" from its own block first,
+ * then from other threads' blocks, "k" holds the block currently pulled from,
+ * return -1 if none left.
+ */
+rt_si32 rt_Scene::row_slice(rt_si32 index, rt_si32 *k)
+{
+    rt_si32 j, m, e;
+
+    for (; *k < index + thnum; *k += 1)
+    {
+        m = *k % thnum;
+        e = tiles_in_col * (m + 1) / thnum;
+
+        /* check before claiming to keep counters from running away */
+        if (tharr[m]->tiles_taken >= e)
+        {
+            continue;
+        }
+
+        j = RT_ATOMIC_ADD(&tharr[m]->tiles_taken, 1);
+
+        if (j < e)
+        {
+            return j;
+        }
+    }
+
+    return -1;
+}
+
+/*
+ * Reset tile-rows counters to the start of each thread's block.
+ */
+rt_void rt_Scene::reset_rows()
+{
+    rt_si32 i;
+
+    for (i = 0; i < thnum; i++)
+    {
+        tharr[i]->tiles_taken = tiles_in_col * i / thnum;
+    }
+}
+
+/*
+ * Release memory for temporary per-frame allocs (cache pools are kept),
+ * grow per-frame pool sizes to the spans used by the released frames,
+ * thus steady-state frames need exactly one chunk per pool.
+ */
+rt_void rt_Scene::release_pools()
+{
+    rt_si32 i;
+    rt_HEAP_STATS hs;
+
+    for (i = 0; i < thnum; i++)
+    {
+        rt_SceneThread *thr = tharr[i];
+
+        if (thr->mpool == RT_NULL || thr->mpool == thr->cpool)
+        {
+            continue;
+        }
+
+        thr->release(thr->mpool);
+        thr->mpool = RT_NULL;
+
+        thr->get_stats(&hs);
+        thr->msize = (rt_ui32)RT_MAX(thr->msize, hs.used);
+    }
+
+    release(mpool);
+    mpool = RT_NULL;
+
+    rt_Registry::get_stats(&hs);
+    msize = (rt_ui32)RT_MAX(msize, hs.used);
+}
+
+/*
+ * Drop all memory pools including the cache pools after an error in render,
+ * which may have left lists half-built and pools reserved at any point,
+ * thus the next frame updates the whole hierarchy, rebuilds lists
+ * and reprojects tile spans from scratch.
+ */
+rt_void rt_Scene::drop_pools()
+{
+    rt_si32 i;
 
-                    /* insert element as list's head */
-                    tls->next = tiles[tline + j];
-                    tiles[tline + j] = tls;
-                }
-            }
+    for (i = 0; i < thnum; i++)
+    {
+        rt_SceneThread *thr = tharr[i];
+
+        /* per-frame pool is either the cache pool or above it */
+        if (thr->cpool != RT_NULL)
+        {
+            thr->release(thr->cpool);
+        }
+        else
+        if (thr->mpool != RT_NULL)
+        {
+            thr->release(thr->mpool);
         }
 
-        if (g_print)
+        thr->mpool = RT_NULL;
+        thr->cpool = RT_NULL;
+    }
+
+    if (mpool != RT_NULL)
+    {
+        release(mpool);
+    }
+
+    mpool = RT_NULL;
+
+    piped = 0;
+    pending = 0;
+
+    /* trigger update of the whole hierarchy,
+     * as failed frame may have stopped halfway through it */
+    rootobj.time = -1;
+    tls_cam = RT_NULL;
+}
+
+/*
+ * Set lists rebuild flag for current frame from objects' changed status
+ * and reserve threads' per-frame pools. If set, the cache pools are dropped
+ * and per-frame pools become new ones,
+ * thus lists built in this frame are kept for the next frames.
+ * Camera's lists and tile lists are rebuilt in per-frame pools anyway.
+ */
+rt_void rt_Scene::reset_lists()
+{
+    rt_si32 i;
+    rt_HEAP_STATS hs;
+
+    rt_Array   *arr;
+    rt_Light   *lgt;
+    rt_Surface *srf;
+
+    /* lists in the cache pools don't depend on cameras,
+     * printing state requires full rebuild */
+    rebuild = g_print || tharr[0]->cpool == RT_NULL;
+
+    for (arr = arr_head; arr != RT_NULL && !rebuild; arr = arr->next)
+    {
+        rebuild = arr->obj_changed != 0;
+    }
+    for (lgt = lgt_head; lgt != RT_NULL && !rebuild; lgt = lgt->next)
+    {
+        rebuild = lgt->obj_changed != 0;
+    }
+    for (srf = srf_head; srf != RT_NULL && !rebuild; srf = srf->next)
+    {
+        rebuild = srf->obj_changed != 0;
+    }
+
+    lst_looks++;
+
+    if (!rebuild)
+    {
+        lst_hits++;
+    }
+
+    for (i = 0; i < thnum; i++)
+    {
+        rt_SceneThread *thr = tharr[i];
+
+        /* drop the cache pool before reserving per-frame pool,
+         * which then becomes new cache pool, thus per-frame pool
+         * doesn't overflow the chunk above the dropped lists */
+        if (rebuild && thr->cpool != RT_NULL)
         {
-            rt_si32 i = 0, j = 0;
+            thr->release(thr->cpool);
+            thr->cpool = RT_NULL;
 
-            tline = i * tiles_in_row;
+            /* grow pool size to the span used by the cache */
+            thr->get_stats(&hs);
+            thr->msize = (rt_ui32)RT_MAX(thr->msize, hs.used);
+        }
 
-            RT_PRINT_TLS_LST(tiles[tline + j], i, j);
+        thr->mpool = thr->reserve(thr->msize, RT_QUAD_ALIGN);
+
+        if (rebuild)
+        {
+            thr->cpool = thr->mpool;
         }
     }
-    else
+}
+
+/*
+ * Assign SIMD-buffers slots to surfaces which can receive rays in this frame,
+ * slots are kept once assigned, threads grow their buffers in 3rd phase.
+ * Primary rays only reach surfaces within tiles, path-tracer's rays
+ * reach any surface, secondary rays from reflective/transparent surfaces
+ * reach surfaces in their lists (which may be reflective/transparent too).
+ * Slots are not recycled, as the list of surfaces is fixed for the scene's
+ * lifetime, buffers are thus bounded by one slot per surface (plus reserved
+ * slot 0 shared by the rest) as they were before slots were introduced.
+ */
+rt_void rt_Scene::reset_bufs()
+{
+    rt_si32 i, n = bfr_num, m;
+
+    rt_Surface *srf;
+    rt_ELEM *elm;
+
+    if ((opts & RT_OPTS_BUFFERS) != 0)
+    {
+        return;
+    }
+
+    rt_bool all = pt_on != 0;
+
+#if RT_OPTS_TILING != 0
+    if ((opts & RT_OPTS_TILING) == 0)
 #endif /* RT_OPTS_TILING */
     {
-        for (i = 0; i < tiles_in_col; i++)
+        all = RT_TRUE;
+    }
+
+    for (srf = srf_head; srf != RT_NULL; srf = srf->next)
+    {
+        if (srf->bfr_slot >= 0 || (!all && srf->tlr_min > srf->tlr_max))
         {
-            tline = i * tiles_in_row;
+            continue;
+        }
 
-            for (j = 0; j < tiles_in_row; j++)
+        srf->bfr_slot = bfr_num++;
+        srf->s_srf->msc_p[0] =
+                (rt_pntr)((rt_word)srf->bfr_slot * RT_BUFFER_POOL);
+    }
+
+    /* surfaces' lists only change when rebuilt, thus secondary rays
+     * only reach new surfaces if new slots were assigned above,
+     * walk lists of surfaces with slots until no new slots are assigned */
+    for (m = all || (!rebuild && n == bfr_num) ? bfr_num : -1; m != bfr_num;)
+    {
+        m = bfr_num;
+
+        for (srf = srf_head; srf != RT_NULL; srf = srf->next)
+        {
+            if (srf->bfr_slot < 0
+            || (((rt_word)srf->s_srf->mat_p[1] & RT_PROP_REFLECT) == 0
+            &&  ((rt_word)srf->s_srf->mat_p[3] & RT_PROP_REFLECT) == 0
+            &&  ((rt_word)srf->s_srf->mat_p[1] & RT_PROP_OPAQUE) != 0
+            &&  ((rt_word)srf->s_srf->mat_p[3] & RT_PROP_OPAQUE) != 0))
             {
-                tiles[tline + j] = clist;
+                continue;
+            }
+
+            /* outer and inner sides' lists are flat,
+             * bvnode elements and accum markers have no bbox */
+            for (i = 1; i < 4; i += 2)
+            {
+                elm = RT_GET_PTR(srf->s_srf->lst_p[i]);
+
+                for (; elm != RT_NULL; elm = elm->next)
+                {
+                    if (elm->temp == RT_NULL)
+                    {
+                        continue;
+                    }
+
+                    rt_Node *nd = (rt_Node *)((rt_BOUND *)elm->temp)->obj;
+                    rt_Surface *ref = (rt_Surface *)nd;
+
+                    if (!RT_IS_SURFACE(nd) || ref->bfr_slot >= 0)
+                    {
+                        continue;
+                    }
+
+                    ref->bfr_slot = bfr_num++;
+                    ref->s_srf->msc_p[0] =
+                        (rt_pntr)((rt_word)ref->bfr_slot * RT_BUFFER_POOL);
+                }
             }
         }
     }
+}
 
-    /* aim rays at pixel centers */
-    RT_VEC3_MUL_VAL1(hor, hor, factor);
-    RT_VEC3_MUL_VAL1(ver, ver, factor);
+/*
+ * Check that threads' hot data (thread's fields, backend structures
+ * and SIMD-buffers) doesn't share cache lines across threads,
+ * enabled as a debug option, throws exception if shared.
+ */
+rt_void rt_Scene::check_lines()
+{
+    rt_si32 i, j, k, l;
 
-    RT_VEC3_MAD_VAL1(dir, hor, 0.5f);
-    RT_VEC3_MAD_VAL1(dir, ver, 0.5f);
+    /* five ranges of cache lines per thread, "beg" > "end" if empty */
+    rt_word *lns = (rt_word *)alloc(sizeof(rt_word) * 10 * thnum, RT_ALIGN);
 
-    /* accumulate ambient from camera and all light sources */
-    RT_VEC3_MUL_VAL1(amb, cam->cam->col.hdr, cam->cam->lum[0]);
-    amb[RT_A] = cam->cam->lum[0];
+    for (i = 0; i < thnum; i++)
+    {
+        rt_SceneThread *thr = tharr[i];
+        rt_word *ln = lns + i * 10;
+
+        ln[0] = (rt_word)thr;
+        ln[1] = ln[0] + sizeof(rt_SceneThread);
+        ln[2] = (rt_word)thr->s_inf;
+        ln[3] = ln[2] + sizeof(rt_SIMD_INFOX);
+        ln[4] = (rt_word)thr->s_cam;
+        ln[5] = ln[4] + sizeof(rt_SIMD_CAMERA);
+        ln[6] = (rt_word)thr->s_ctx;
+        ln[7] = ln[6] + sizeof(rt_SIMD_CONTEXT) + RT_STACK_STEP * (1 + depth);
+        ln[8] = (rt_word)thr->s_inf->bfr_p;
+        ln[9] = ln[8] + RT_BUFFER_POOL * thr->bfr_num;
+
+        for (k = 0; k < 10; k += 2)
+        {
+            if (ln[k] == ln[k + 1])
+            {
+                ln[k + 0] = 1;
+                ln[k + 1] = 0;
+                continue;
+            }
 
-    rt_Light *lgt = RT_NULL;
+            ln[k + 0] = (ln[k + 0] + 0) / RT_CACHE_LINE;
+            ln[k + 1] = (ln[k + 1] - 1) / RT_CACHE_LINE;
+        }
+    }
 
-    for (lgt = lgt_head; lgt != RT_NULL; lgt = lgt->next)
+    for (i = 0; i < thnum; i++)
     {
-        RT_VEC3_MAD_VAL1(amb, lgt->lgt->col.hdr, lgt->lgt->lum[0]);
-        amb[RT_A] += lgt->lgt->lum[0];
+        for (j = i + 1; j < thnum; j++)
+        {
+            rt_word *a = lns + i * 10, *b = lns + j * 10;
+
+            for (k = 0; k < 10; k += 2)
+            {
+                for (l = 0; l < 10; l += 2)
+                {
+                    if (a[k] <= b[l + 1] && b[l] <= a[k + 1])
+                    {
+                        throw rt_Exception("threads share cache lines");
+                    }
+                }
+            }
+        }
     }
+}
 
-#if RT_OPTS_UPDATE_EXT0 != 0
-    } /* --<----<-- skip update1 --<----<-- */
-#endif /* RT_OPTS_UPDATE_EXT0 */
+/*
+ * Split the hierarchy into top arrays and sub-trees below them
+ * for multi-threaded parts of phases 0.5 and 2.5.
+ */
+rt_void rt_Scene::init_subs()
+{
+    rt_si32 i, j, k, s, n = cam_num + lgt_num + arr_num + srf_num;
 
+    top_arr = (rt_Array **)alloc(sizeof(rt_Array *) * arr_num, RT_ALIGN);
+    sub_arr = (rt_Object **)alloc(sizeof(rt_Object *) * n, RT_ALIGN);
+    sub_bnd = (rt_si32 *)alloc(sizeof(rt_si32) * n, RT_ALIGN);
 
-#if RT_OPTS_RENDER_EXT0 != 0
-    if ((opts & RT_OPTS_RENDER_EXT0) == 0)
-    { /* -->---->-- skip render0 -->---->-- */
-#endif /* RT_OPTS_RENDER_EXT0 */
+    top_num = 0;
+    sub_num = 0;
 
-#if 0 /* SIMD-buffers don't normally require reset between frames */
-    reset_color();
-#endif /* enable for SIMD-buffers as a debug option if needed */
+    /* single thread updates the whole hierarchy */
+    if (thnum <= 1)
+    {
+        return;
+    }
 
-    /* multi-threaded render */
-#if RT_OPTS_THREAD != 0
-    if ((opts & RT_OPTS_THREAD) != 0 && this == pfm->get_cur_scene()
-#if RT_OPTS_RENDER_EXT1 != 0
-    &&  (opts & RT_OPTS_RENDER_EXT1) == 0
-#endif /* RT_OPTS_RENDER_EXT1 */
-       )
+    sub_arr[sub_num++] = root;
+
+    rt_Array *arr;
+
+    /* split arrays level by level, until there are enough sub-trees */
+    for (s = sub_num; ; s = sub_num)
     {
-        this->f_render(tdata, thnum, 1);
+        for (i = 0; i < s && !RT_IS_ARRAY(sub_arr[i]); i++);
+
+        if (i == s || s >= RT_SUB_TREES * thnum)
+        {
+            break;
+        }
+
+        for (i = 0, j = 0; i < s; i++)
+        {
+            if (!RT_IS_ARRAY(sub_arr[i]))
+            {
+                sub_arr[j++] = sub_arr[i];
+                continue;
+            }
+
+            arr = (rt_Array *)sub_arr[i];
+            top_arr[top_num++] = arr;
+
+            for (k = 0; k < arr->obj_num; k++)
+            {
+                sub_arr[sub_num++] = arr->obj_arr[k];
+            }
+        }
+
+        /* move sub-objects of split arrays next to the kept ones */
+        for (i = s; i < sub_num; i++)
+        {
+            sub_arr[j++] = sub_arr[i];
+        }
+
+        sub_num = j;
     }
-    else
-#endif /* RT_OPTS_THREAD */
+
+    for (i = 0; i < sub_num; i++)
     {
-        render_scene(this, -thnum, 1);
+        sub_bnd[i] = RT_IS_ARRAY(sub_arr[i]) ? 1 : 0;
     }
 
-    pts_c = tharr[0]->s_inf->pts_c[0];
+    rt_Surface *srf;
 
-#if RT_OPTS_RENDER_EXT0 != 0
-    } /* --<----<-- skip render0 --<----<-- */
-#endif /* RT_OPTS_RENDER_EXT0 */
+    /* bounds are contributed in-order to the bvnodes (reset by them first),
+     * thus sub-tree can only be updated separately if its objects
+     * don't contribute to bvnodes outside of it and vice versa */
+    for (arr = arr_head; arr != RT_NULL; arr = arr->next)
+    {
+        if (arr->bvnode == RT_NULL)
+        {
+            continue;
+        }
 
+        j = find_sub(arr->parent);
+        k = find_sub(arr->bvnode);
 
-#if RT_OPTS_UPDATE_EXT0 != 0
-    if ((opts & RT_OPTS_UPDATE_EXT0) == 0)
-    { /* -->---->-- skip update2 -->---->-- */
-#endif /* RT_OPTS_UPDATE_EXT0 */
+        if (j != k)
+        {
+            if (j >= 0) sub_bnd[j] = 0;
+            if (k >= 0) sub_bnd[k] = 0;
+        }
+    }
 
-    /* print state done */
-    if (g_print)
+    for (srf = srf_head; srf != RT_NULL; srf = srf->next)
     {
-        RT_PRINT_STATE_DONE();
-        g_print = RT_FALSE;
+        if (srf->bvnode == RT_NULL)
+        {
+            continue;
+        }
+
+        j = find_sub(srf->parent);
+        k = find_sub(srf->bvnode);
+
+        if (j != k)
+        {
+            if (j >= 0) sub_bnd[j] = 0;
+            if (k >= 0) sub_bnd[k] = 0;
+        }
+    }
+}
+
+/*
+ * Find sub-tree containing object "obj", return -1 if none.
+ */
+rt_si32 rt_Scene::find_sub(rt_Object *obj)
+{
+    rt_si32 i;
+
+    for (; obj != RT_NULL; obj = obj->parent)
+    {
+        for (i = 0; i < sub_num; i++)
+        {
+            if (sub_arr[i] == obj)
+            {
+                return i;
+            }
+        }
+    }
+
+    return -1;
+}
+
+/*
+ * Update portion of the scene with given "index"
+ * as part of the multi-threaded update.
+ */
+rt_void rt_Scene::update_slice(rt_si32 index, rt_si32 phase)
+{
+    rt_si32 i, n = -RT_SRF_CHUNK;
+
+    rt_Array   *arr;
+    rt_Camera  *cam;
+    rt_Light   *lgt;
+    rt_Surface *srf;
+    rt_Object  *obj;
+
+    if (phase == 6)
+    {
+        for (srf = srf_head, i = 0; srf != RT_NULL; srf = srf->next, i++)
+        {
+            if (!srf_slice(index, i, &n))
+            {
+                continue;
+            }
+
+            /* rebuild surface's node list (per-surface)
+             * based on transform flags and arrays' bounds */
+            tharr[index]->snode(srf);
+        }
     }
+    else
+    if (phase == 7)
+    {
+        /* global lists are built by two threads in parallel
+         * (or by the same thread) from surfaces' node lists */
+        if (index == 0)
+        {
+            /* rebuild global hierarchical list,
+             * kept in the cache pool if not "rebuild" */
+            if (rebuild)
+            {
+                hlist = tharr[index]->ssort(RT_NULL);
+            }
+
+            /* rebuild camera's surface/node list */
+            clist = tharr[index]->ssort(this->cam);
+
+            rt_ELEM *elm, *nxt, **ptr = &rlist;
+
+            rlist = RT_NULL;
+
+            /* build exact copy of reversed "clist" (should be cheap),
+             * trnode elements become tailing rather than heading,
+             * elements grouping for cached transform is retained */
+            for (nxt = clist; nxt != RT_NULL; nxt = nxt->next)
+            {
+                /* alloc new element as "nxt's" copy */
+                elm = (rt_ELEM *)tharr[index]->alloc(sizeof(rt_ELEM),
+                                                            RT_QUAD_ALIGN);
+                elm->data = nxt->data;
+                elm->simd = nxt->simd;
+                elm->temp = nxt->temp;
+                /* insert element as list's head */
+                elm->next = *ptr;
+               *ptr = elm;
+            }
+        }
 
-    /* release memory for temporary per-frame allocs */
-    for (i = 0; i < thnum; i++)
-    {
-        tharr[i]->release(tharr[i]->mpool);
-    }
+        if (index == 1 % thnum && rebuild)
+        {
+            /* rebuild global surface/node list */
+            slist = tharr[index]->ssort(RT_NULL);
+            tharr[index]->filter(RT_NULL, &slist);
 
-    release(mpool);
+            /* rebuild or refit bvnode tree over "slist",
+             * reorder "slist" along the tree */
+            tharr[index]->btree();
 
-#if RT_OPTS_UPDATE_EXT0 != 0
-    } /* --<----<-- skip update2 --<----<-- */
+            /* rebuild global light/shadow list,
+             * "slist" is needed inside */
+            llist = tharr[index]->lsort(RT_NULL);
+        }
+    }
     else
+    if (phase == 4)
     {
-        pending = 1;
-    }
-#endif /* RT_OPTS_UPDATE_EXT0 */
-}
+        /* threads pull sub-trees from the shared counter,
+         * as sub-trees vary in size */
+        while ((i = RT_ATOMIC_ADD(&subs_taken, 1)) < sub_num)
+        {
+            obj = sub_arr[i];
 
-/*
- * Update portion of the scene with given "index"
- * as part of the multi-threaded update.
- */
-rt_void rt_Scene::update_slice(rt_si32 index, rt_si32 phase)
-{
-    rt_si32 i;
+            /* update sub-tree's transform matrices (phase 0.5)
+             * from parent array's head updated sequentially */
+            ((rt_Array *)obj->parent)->update_child(subs_t, obj, RT_TRUE);
+        }
+    }
+    else
+    if (phase == 5)
+    {
+        while ((i = RT_ATOMIC_ADD(&subs_taken, 1)) < sub_num)
+        {
+            obj = sub_arr[i];
 
-    rt_Array   *arr;
-    rt_Camera  *cam;
-    rt_Light   *lgt;
-    rt_Surface *srf;
+            /* update sub-tree's bounds (phase 2.5) if self-contained,
+             * otherwise it's updated in place by the sequential part,
+             * trnode up in the hierarchy collects sub-tree's bounds */
+            if (sub_bnd[i] == 0
+            || (obj->trnode != RT_NULL && obj->trnode != obj))
+            {
+                continue;
+            }
 
+            arr = (rt_Array *)obj;
+            arr->update_bounds();
+            arr->bnd_done = 1;
+        }
+    }
+    else
     if (phase == 1)
     {
         for (arr = arr_head, i = 0; arr != RT_NULL; arr = arr->next, i++)
@@ -3406,7 +4958,7 @@ rt_void rt_Scene::update_slice(rt_si32 index, rt_si32 phase)
             }
 
             /* update array's fields from transform matrix
-             * updated in sequential phase 0.5 */
+             * updated in phase 0.5 */
             arr->update_fields();
         }
 
@@ -3419,7 +4971,7 @@ rt_void rt_Scene::update_slice(rt_si32 index, rt_si32 phase)
 
             /* update camera's fields and transform matrix
              * from parent array's transform matrix
-             * updated in sequential phase 0.5 */
+             * updated in phase 0.5 */
             cam->update_fields();
         }
 
@@ -3432,7 +4984,7 @@ rt_void rt_Scene::update_slice(rt_si32 index, rt_si32 phase)
 
             /* update light's fields and transform matrix
              * from parent array's transform matrix
-             * updated in sequential phase 0.5 */
+             * updated in phase 0.5 */
             lgt->update_fields();
         }
 
@@ -3445,7 +4997,7 @@ rt_void rt_Scene::update_slice(rt_si32 index, rt_si32 phase)
 
             /* update surface's fields and transform matrix
              * from parent array's transform matrix
-             * updated in sequential phase 0.5 */
+             * updated in phase 0.5 */
             srf->update_fields();
         }
     }
@@ -3454,14 +5006,17 @@ rt_void rt_Scene::update_slice(rt_si32 index, rt_si32 phase)
     {
         for (srf = srf_head, i = 0; srf != RT_NULL; srf = srf->next, i++)
         {
-            if ((i % thnum) != index)
+            if (!srf_slice(index, i, &n))
             {
                 continue;
             }
 
             /* rebuild surface's clip list (cross-surface)
              * based on transform flags updated in 1st phase above */
-            tharr[index]->sclip(srf);
+            if (rebuild)
+            {
+                tharr[index]->sclip(srf);
+            }
 
             /* update surface's bounds taking into account surfaces
              * from custom clippers list updated above */
@@ -3475,9 +5030,18 @@ rt_void rt_Scene::update_slice(rt_si32 index, rt_si32 phase)
     else
     if (phase == 3)
     {
+        /* alloc thread's scratch for reordering
+         * surface lists along the bvnode tree */
+        if (rebuild && tree_num > 0)
+        {
+            tharr[index]->tree_elm = (rt_ELEM **)
+                tharr[index]->alloc(sizeof(rt_ELEM *) * tree_num, RT_ALIGN);
+            memset(tharr[index]->tree_elm, 0, sizeof(rt_ELEM *) * tree_num);
+        }
+
         for (srf = srf_head, i = 0; srf != RT_NULL; srf = srf->next, i++)
         {
-            if ((i % thnum) != index)
+            if (!srf_slice(index, i, &n))
             {
                 continue;
             }
@@ -3489,21 +5053,37 @@ rt_void rt_Scene::update_slice(rt_si32 index, rt_si32 phase)
 
             /* rebuild surface's rfl/rfr surface lists (cross-surface)
              * based on surface bounds updated in 2nd phase above
-             * and array bounds updated in sequential phase 2.5 */
-            tharr[index]->ssort(srf);
+             * and array bounds updated in phase 2.5 */
+            if (rebuild)
+            {
+                tharr[index]->ssort(srf);
+            }
 
             /* rebuild surface's light/shadow lists (cross-surface)
              * based on surface bounds updated in 2nd phase above
-             * and array bounds updated in sequential phase 2.5 */
-            tharr[index]->lsort(srf);
+             * and array bounds updated in phase 2.5 */
+            if (rebuild)
+            {
+                tharr[index]->lsort(srf);
+            }
 
             /* update surface's backend-related parts */
             pfm->update0(srf->s_srf);
+        }
 
-#if 0 /* SIMD-buffers don't normally require reset between frames */
-            memset(srf->s_srf->msc_p[0], 255, RT_BUFFER_POOL*thnum);
-#endif /* enable for SIMD-buffers as a debug option if needed */
+        /* grow thread's SIMD-buffers for slots
+         * assigned to surfaces before 3rd phase */
+        tharr[index]->grow_bufs(bfr_num);
+
+#if RT_OPTS_TILING != 0
+        if ((opts & RT_OPTS_TILING) != 0)
+        {
+            /* build tile lists for thread's own block of tile-rows
+             * from surfaces' tiles lists updated in 2nd phase above */
+            tharr[index]->tsort(tiles_in_col * index / thnum,
+                                tiles_in_col * (index + 1) / thnum);
         }
+#endif /* RT_OPTS_TILING */
     }
 }
 
@@ -3513,6 +5093,55 @@ rt_void rt_Scene::update_slice(rt_si32 index, rt_si32 phase)
  */
 rt_void rt_Scene::render_slice(rt_si32 index, rt_si32 phase)
 {
+    /* first-touch phase, run once from scene's constructor */
+    if (phase == 0)
+    {
+        rt_SceneThread *thr = tharr[index];
+
+        rt_si32 y, y_s, y_e;
+
+        /* rows of thread's own block of tile-rows */
+        y_s = RT_MIN(y_res, tiles_in_col * index / thnum * pfm->tile_h);
+        y_e = RT_MIN(y_res, tiles_in_col * (index + 1) / thnum * pfm->tile_h);
+
+        for (y = y_s; y < y_e; y++)
+        {
+            memset(frame + y * x_row, 0, RT_ABS32(x_row) * sizeof(rt_ui32));
+
+            if (ptr_r != RT_NULL)
+            {
+                memset(ptr_r + y * 4 * x_row, 0, 4 * x_row * sizeof(rt_real));
+                memset(ptr_g + y * 4 * x_row, 0, 4 * x_row * sizeof(rt_real));
+                memset(ptr_b + y * 4 * x_row, 0, 4 * x_row * sizeof(rt_real));
+            }
+            if (pseed != RT_NULL)
+            {
+                memset(pseed + y * 4 * x_row, 0, 4 * x_row * sizeof(rt_elem));
+            }
+        }
+
+        /* per-frame pool's chunk is kept across frames,
+         * release right after touching it, so that every frame
+         * pairs its own reserve with release in "release_pools" */
+        thr->mpool = thr->reserve(thr->msize, RT_QUAD_ALIGN);
+        memset(thr->mpool, 0, thr->msize);
+        thr->release(thr->mpool);
+        thr->mpool = RT_NULL;
+
+        return;
+    }
+
+    /* in pipelined render thread 0 runs phase 0.5 of the next frame
+     * before joining, it only writes host-side state of objects
+     * (status, matrices, trnodes) and scene data via animators,
+     * while render below only reads SIMD-structures, per-frame lists
+     * and scene's own ray-positioning kept from the update above,
+     * phases 1 to 3 write SIMD-structures and run after the render */
+    if (phase == 2 && index == 0)
+    {
+        root->update_object(pipe_t, 0, RT_NULL, iden4);
+    }
+
     /* adjust ray steppers according to antialiasing mode */
     rt_real fha[RT_SIMD_WIDTH], fhi[RT_SIMD_WIDTH], fhu; /* h - hor */
     rt_real fva[RT_SIMD_WIDTH], fvi[RT_SIMD_WIDTH], fvu; /* v - ver */
@@ -3647,7 +5276,7 @@ rt_void rt_Scene::render_slice(rt_si32 index, rt_si32 phase)
     rt_SIMD_CONTEXT *s_ctx = tharr[index]->s_ctx;
 
     s_ctx->param[1] = -((opts & RT_OPTS_GAMMA) == 0) & RT_PROP_GAMMA;
-    RT_SIMD_SET(s_ctx->t_min, cam->pov);
+    RT_SIMD_SET(s_ctx->t_min, pov);
     RT_SIMD_SET(s_ctx->wmask, -1);
 
     RT_SIMD_SET(s_ctx->org_x, pos[RT_X]);
@@ -3671,27 +5300,86 @@ rt_void rt_Scene::render_slice(rt_si32 index, rt_si32 phase)
 
     RT_SIMD_SET(s_inf->pts_c, pts_c);
 
-    for (n = RT_MAX(1, pt_on); n > 0; n--)
+    /* occluder cache is keyed by light elements, which may move
+     * when lists are rebuilt, thus it's kept only within a frame */
+    if (s_inf->shw_p != RT_NULL)
     {
-        /* use of integer indices for primary rays update
-         * makes related fp-math independent from SIMD width */
-        for (i = 0; i < pfm->simd_width; i++)
+        memset(s_inf->shw_p, 0, sizeof(rt_ELEM) * RT_SHW_SLOTS);
+    }
+
+    /* by default every thread renders each "thnum"-th row of the frame */
+    s_inf->row_s = index;
+    s_inf->row_e = y_res;
+    s_inf->row_u = thnum;
+
+    rt_si32 j = 0, k = 0, m = index;
+    rt_bool pull = RT_FALSE;
+
+#if RT_OPTS_THREAD_EXT1 != 0
+    /* otherwise threads pull tile-rows from their own blocks,
+     * then steal from other blocks until there are none left,
+     * thus balancing uneven rows while keeping memory locality */
+    if ((opts & RT_OPTS_THREAD_EXT1) != 0)
+    {
+        pull = RT_TRUE;
+
+        RT_SIMD_SET(s_cam->ver_u, (rt_real)1);
+        s_inf->row_u = 1;
+    }
+#endif /* RT_OPTS_THREAD_EXT1 */
+
+    while (!pull || (j = row_slice(index, &m)) >= 0)
+    {
+        if (pull)
+        {
+            s_inf->row_s = j * pfm->tile_h;
+            s_inf->row_e = RT_MIN(y_res, (j + 1) * pfm->tile_h);
+
+            for (i = 0; i < pfm->simd_width; i++)
+            {
+                fvi[i] = (rt_real)(j * pfm->tile_h);
+            }
+
+            /* path-tracer samples are counted per tile-row */
+            RT_SIMD_SET(s_inf->pts_c, pts_c);
+        }
+
+        for (n = RT_MAX(1, pt_on); n > 0; n--)
         {
-            s_cam->index[i] = i;
-            s_inf->hor_c[i] = fhi[i];
+            /* use of integer indices for primary rays update
+             * makes related fp-math independent from SIMD width */
+            for (i = 0; i < pfm->simd_width; i++)
+            {
+                s_cam->index[i] = i;
+                s_inf->hor_c[i] = fhi[i];
+
+                s_inf->hor_i[i] = fhi[i];
+                s_inf->ver_i[i] = fvi[i];
+
+                s_cam->hor_a[i] = fha[i];
+                s_cam->ver_a[i] = fva[i];
+            }
 
-            s_inf->hor_i[i] = fhi[i];
-            s_inf->ver_i[i] = fvi[i];
+            s_inf->depth = depth;
+            RT_SIMD_SET(s_ctx->wmask, -1);
 
-            s_cam->hor_a[i] = fha[i];
-            s_cam->ver_a[i] = fva[i];
+            /* render frame based on tilebuffer */
+            pfm->render0(s_inf);
         }
 
-        s_inf->depth = depth;
-        RT_SIMD_SET(s_ctx->wmask, -1);
+        k++;
+
+        if (!pull)
+        {
+            break;
+        }
+    }
 
-        /* render frame based on tilebuffer */
-        pfm->render0(s_inf);
+    /* keep samples count consistent
+     * if no tile-rows were left for this thread */
+    if (k == 0)
+    {
+        RT_SIMD_SET(s_inf->pts_c, pt_on != 0 ? pts_c + (rt_real)pt_on : 0.0f);
     }
 }
 
@@ -3713,6 +5401,60 @@ rt_void rt_Scene::print_state()
     g_print = RT_TRUE;
 }
 
+/*
+ * Get memory usage counters summed over scene's heap and threads' heaps,
+ * "peak" is the per-frame footprint, "total" includes all scene data.
+ */
+rt_void rt_Scene::get_stats(rt_HEAP_STATS *stats)
+{
+    rt_si32 i;
+    rt_HEAP_STATS hs;
+
+    rt_Registry::get_stats(stats);
+
+    for (i = 0; i < thnum; i++)
+    {
+        tharr[i]->get_stats(&hs);
+
+        stats->used         += hs.used;
+        stats->peak         += hs.peak;
+        stats->waste        += hs.waste;
+        stats->total        += hs.total;
+        stats->chunks       += hs.chunks;
+        stats->grows        += hs.grows;
+        stats->spans        += hs.spans;
+        stats->span_grows   += hs.span_grows;
+    }
+}
+
+/*
+ * Get shadow occluder cache statistics summed over threads,
+ * "hits" count shadow rays stopped by the cached occluder.
+ */
+rt_void rt_Scene::get_shadow_stats(rt_ui64 *looks, rt_ui64 *hits)
+{
+    rt_si32 i;
+
+   *looks = 0;
+   *hits  = 0;
+
+    for (i = 0; i < thnum; i++)
+    {
+       *looks += tharr[i]->s_inf->shw_l;
+       *hits  += tharr[i]->s_inf->shw_h;
+    }
+}
+
+/*
+ * Get lists cache statistics, "looks" count frames which checked lists
+ * in the cache pools, "hits" count frames which kept them.
+ */
+rt_void rt_Scene::get_lists_stats(rt_si32 *looks, rt_si32 *hits)
+{
+   *looks = lst_looks;
+   *hits  = lst_hits;
+}
+
 /*
  * Generate next random number using XX-bit LCG method.
  */
@@ -3822,6 +5564,234 @@ rt_si32 rt_Scene::set_pton(rt_si32 pton)
     return this->pt_on;
 }
 
+/*
+ * Get pipelined mode: 0 - off, 1 - on (output lags by one call to render).
+ */
+rt_si32 rt_Scene::get_pipe()
+{
+    return this->pipe_on;
+}
+
+/*
+ * Set pipelined mode: 0 - off, 1 - on (output lags by one call to render).
+ * In pipelined mode animators of the next frame run concurrently with
+ * render threads of the current one, thus animators may only write
+ * their own transforms and scene data, not anything read by the render
+ * (such as frame, textures or materials), which stays the same until
+ * the lagged frame is output by the next call.
+ */
+rt_si32 rt_Scene::set_pipe(rt_si32 pipe)
+{
+    this->pipe_on = pipe;
+
+    return this->pipe_on;
+}
+
+/*
+ * Point scene and its threads to a given frame of the same dimensions.
+ */
+rt_void rt_Scene::set_frame(rt_ui32 *frame)
+{
+    rt_si32 i;
+
+    this->frame = frame;
+
+    for (i = 0; i < thnum; i++)
+    {
+        tharr[i]->s_inf->frame = frame;
+    }
+}
+
+/*
+ * Set async render with a ring of "num" frames: 0 - off (default),
+ * return number of frames in the ring. Waits for submitted frames to finish.
+ * Pipelined mode is not used while async render is on.
+ */
+rt_si32 rt_Scene::set_ring(rt_si32 num)
+{
+    rt_si32 i;
+
+    if (async != RT_NULL)
+    {
+        /* pool's destructor finishes posted frames */
+        delete async->pool;
+        delete async;
+        async = RT_NULL;
+
+        set_frame(ring[0]);
+    }
+
+    ring_num = RT_MAX(num, 0);
+
+    if (ring_num == 0)
+    {
+        return ring_num;
+    }
+
+    /* drop the lagged frame (as pipelining is off with async render)
+     * or the pending one, so that no per-frame pool is reserved
+     * and frames of the ring are not released along with it */
+    if (piped || pending)
+    {
+        piped = 0;
+        pending = 0;
+
+        release_pools();
+    }
+
+    /* frames are allocated once per scene,
+     * the ring only grows in size */
+    if (ring_num > ring_max)
+    {
+        rt_ui32 **ring = (rt_ui32 **)
+                alloc(ring_num * sizeof(rt_ui32 *), RT_ALIGN);
+
+        ring[0] = frame;
+
+        for (i = 1; i < ring_num; i++)
+        {
+            if (i < ring_max)
+            {
+                ring[i] = this->ring[i];
+                continue;
+            }
+
+            ring[i] = (rt_ui32 *)
+                alloc(RT_ABS32(x_row) * y_res * sizeof(rt_ui32), RT_SIMD_ALIGN);
+
+            memset(ring[i], 0, RT_ABS32(x_row) * y_res * sizeof(rt_ui32));
+
+            if (x_row < 0)
+            {
+                ring[i] += RT_ABS32(x_row) * (y_res - 1);
+            }
+        }
+
+        this->ring = ring;
+        ring_max = ring_num;
+
+        ring_t = (rt_time *)
+                alloc(ring_num * sizeof(rt_time), RT_ALIGN);
+        ring_e = (rt_pstr *)
+                alloc(ring_num * sizeof(rt_pstr), RT_ALIGN);
+    }
+
+    async = new rt_SceneAsync;
+
+    async->sub = 0;
+
+    /* frames are rendered in order by the built-in pool's
+     * single thread, which posts its phases to scene's threads */
+    async->pool = new rt_ThreadPool(1, RT_POOL_SPIN);
+
+    return ring_num;
+}
+
+/*
+ * Async render of the frame with a given "fence",
+ * run by the thread of scene's async pool in order of submission.
+ */
+rt_void rt_Scene::run_async(rt_si32 fence)
+{
+    rt_si32 k = fence % ring_num;
+
+    set_frame(ring[k]);
+
+    /* frame's error is kept in its slot, it is published
+     * along with the frame once the pool marks the job done */
+    ring_e[k] = RT_NULL;
+
+    try
+    {
+        render(ring_t[k]);
+    }
+    catch (rt_Exception e)
+    {
+        ring_e[k] = e.err;
+
+        /* render may have stopped with pools reserved,
+         * drop them so that next frame starts clean */
+        drop_pools();
+    }
+}
+
+/*
+ * Submit frame for a given "time" to async render, return its fence.
+ * Blocks while all frames in the ring are in flight.
+ */
+rt_si32 rt_Scene::submit(rt_time time)
+{
+    if (async == RT_NULL)
+    {
+        throw rt_Exception("async render is off, set ring of frames first");
+    }
+
+    rt_si32 fence = async->sub++;
+
+    /* wait for the frame previously rendered into the same slot */
+    if (fence >= ring_num)
+    {
+        async->pool->sync((rt_ui32)(fence - ring_num));
+    }
+
+    ring_t[fence % ring_num] = time;
+
+    async->pool->post(slice_async, this, fence);
+
+    return fence;
+}
+
+/*
+ * Return true if frame with a given "fence" is finished.
+ */
+rt_bool rt_Scene::poll(rt_si32 fence)
+{
+    if (async == RT_NULL)
+    {
+        return RT_TRUE;
+    }
+
+    if (fence < async->sub - ring_num)
+    {
+        throw rt_Exception("frame of the fence was reused by a later submit");
+    }
+
+    return fence < async->sub ? async->pool->done((rt_ui32)fence) : RT_FALSE;
+}
+
+/*
+ * Wait for frame with a given "fence" to finish, return its frame.
+ * Exception thrown by async render is passed on to the caller.
+ */
+rt_ui32* rt_Scene::wait(rt_si32 fence)
+{
+    if (async == RT_NULL)
+    {
+        return frame;
+    }
+
+    if (fence >= async->sub)
+    {
+        throw rt_Exception("waiting for a frame not yet submitted");
+    }
+
+    if (fence < async->sub - ring_num)
+    {
+        throw rt_Exception("frame of the fence was reused by a later submit");
+    }
+
+    async->pool->sync((rt_ui32)fence);
+
+    rt_si32 k = fence % ring_num;
+
+    if (ring_e[k] != RT_NULL)
+    {
+        throw rt_Exception(ring_e[k]);
+    }
+
+    return ring[k];
+}
+
 /*
  * Return current camera index.
  */
@@ -3913,6 +5883,9 @@ rt_Scene::~rt_Scene()
 {
     rt_si32 i;
 
+    /* finish async render */
+    set_ring(0);
+
     pfm->del_scene(this);
 
     /* destroy scene threads array */
@@ -38,6 +38,15 @@
 #define RT_TILE_W               8  /* screen tile width  in pixels (%S == 0) */
 #define RT_TILE_H               8  /* screen tile height in pixels */
 
+#define RT_SRF_CHUNK            4  /* surfaces per claim in update phases */
+#define RT_SUB_TREES            4  /* sub-trees per thread in phases 0.5/2.5 */
+
+#define RT_TREE_LEAF            4  /* max surfaces per leaf of bvnode tree */
+#define RT_TREE_SPLIT           2  /* binary splits per bvnode (4-ary tree) */
+#define RT_TREE_REFIT           16 /* refits of bvnode tree per full split */
+
+#define RT_SHW_SLOTS            64 /* shadow occluder cache slots (2^n or 0) */
+
 /*
  * Floating point thresholds,
  * values have been roughly selected for single-precision,
@@ -64,14 +73,20 @@ class rt_Platform;
 class rt_SceneThread;
 class rt_Scene;
 
+struct rt_SceneAsync;
+
 /******************************************************************************/
 /*****************************   MULTI-THREADING   ****************************/
 /******************************************************************************/
 
 typedef rt_pntr (*rt_FUNC_INIT)(rt_si32 thnum, rt_Platform *pfm);
 typedef rt_void (*rt_FUNC_TERM)(rt_pntr tdata, rt_si32 thnum);
-typedef rt_void (*rt_FUNC_UPDATE)(rt_pntr tdata, rt_si32 thnum, rt_si32 phase);
-typedef rt_void (*rt_FUNC_RENDER)(rt_pntr tdata, rt_si32 thnum, rt_si32 phase);
+/* update/render run "thnum" slices of the given scene ("scn"),
+ * thread-pool may take jobs from several scenes at the same time */
+typedef rt_void (*rt_FUNC_UPDATE)(rt_pntr tdata, rt_Scene *scn,
+                                  rt_si32 thnum, rt_si32 phase);
+typedef rt_void (*rt_FUNC_RENDER)(rt_pntr tdata, rt_Scene *scn,
+                                  rt_si32 thnum, rt_si32 phase);
 
 /*
  * Platform abstraction container.
@@ -192,15 +207,40 @@ class rt_SceneThread : public rt_Heap
      * for temporary per-frame allocs */
     rt_pntr             mpool;
     rt_ui32             msize;
+    /* memory pool in the heap for lists
+     * kept across frames (until invalidated) */
+    rt_pntr             cpool;
+
+    /* SIMD-buffers shared by surfaces with
+     * slots in the scene (outside the heap) */
+    rt_pntr             bfr_p;
+    rt_si32             bfr_num;
+
+    /* list's surfaces in bvnode tree order,
+     * scratch for reordering lists along the tree */
+    rt_ELEM           **tree_elm;
+
+    /* tile-rows counter for render within thread's
+     * own block, other threads steal from it when done,
+     * padded off the cache lines of thread's other fields */
+    rt_byte             pad00[RT_CACHE_LINE];
+    volatile
+    rt_si32             tiles_taken;
+    rt_byte             pad01[RT_CACHE_LINE];
 
 /*  methods */
 
     private:
 
     rt_void     tiling(rt_vec2 p1, rt_vec2 p2);
+    rt_void     ptile(rt_Surface *srf);
 
     rt_ELEM*    insert(rt_Object *obj, rt_ELEM **ptr, rt_ELEM *tem);
 
+    rt_void     tsplit(rt_vec4 *bnd, rt_si32 i0, rt_si32 i1, rt_si32 d,
+                       rt_bool fit);
+    rt_ELEM*    tnode(rt_ELEM **ptr, rt_si32 i0, rt_si32 i1, rt_si32 d);
+
     public:
 
     rt_ELEM*    filter(rt_Object *obj, rt_ELEM **ptr);
@@ -219,6 +259,15 @@ class rt_SceneThread : public rt_Heap
 
     rt_ELEM*    ssort(rt_Object *obj);
     rt_ELEM*    lsort(rt_Object *obj);
+
+    rt_void     tsort(rt_si32 i0, rt_si32 i1);
+    rt_void     tclose(rt_ELEM *slb, rt_si32 *pos, rt_si32 *grp,
+                       rt_Surface **opn, rt_si32 k);
+
+    rt_void     btree();
+    rt_void     stree(rt_ELEM **ptr);
+
+    rt_void     grow_bufs(rt_si32 num);
 };
 
 /******************************************************************************/
@@ -276,6 +325,35 @@ class rt_Scene : private rt_Registry, public rt_List<rt_Scene>
     rt_ui32             msize;
     /* pending release flag */
     rt_si32             pending;
+    /* lists rebuild flag for current frame,
+     * lists are kept in threads' cache pools otherwise */
+    rt_si32             rebuild;
+    /* number of frames which checked lists
+     * and of those which kept them (cache hits) */
+    rt_si32             lst_looks;
+    rt_si32             lst_hits;
+    /* tile spans reprojection flag for current frame,
+     * spans are kept in surfaces otherwise */
+    rt_si32             tls_changed;
+    /* number of SIMD-buffers slots
+     * assigned to surfaces so far (including reserved 0) */
+    rt_si32             bfr_num;
+    /* pipelined mode and lagged frame flags */
+    rt_si32             pipe_on;
+    rt_si32             piped;
+    /* time of the next frame's phase 0.5 */
+    rt_time             pipe_t;
+
+    /* ring of output frames for async render,
+     * ring[0] is the scene's original frame,
+     * with time and render error per frame */
+    rt_ui32           **ring;
+    rt_time            *ring_t;
+    rt_pstr            *ring_e;
+    rt_si32             ring_num;
+    rt_si32             ring_max;
+    /* async render thread and fences */
+    rt_SceneAsync      *async;
 
     /* thread management functions */
     rt_FUNC_UPDATE      f_update;
@@ -286,6 +364,31 @@ class rt_Scene : private rt_Registry, public rt_List<rt_Scene>
     rt_si32             thnum;
     rt_SceneThread    **tharr;
     rt_pntr             tdata;
+    /* surface-chunks counter for update,
+     * shared between threads (padded) */
+    rt_byte             pad00[RT_CACHE_LINE];
+    volatile
+    rt_si32             srfs_taken;
+    rt_byte             pad01[RT_CACHE_LINE];
+
+    /* top arrays of the hierarchy updated sequentially
+     * (parents first) and sub-trees below them,
+     * shared between threads in phases 0.5 and 2.5 */
+    rt_Array          **top_arr;
+    rt_si32             top_num;
+    rt_Object         **sub_arr;
+    rt_si32             sub_num;
+    /* non-zero if sub-tree's bounds don't depend
+     * on bvnodes outside of it (and vice versa) */
+    rt_si32            *sub_bnd;
+    /* sub-trees counter for update,
+     * shared between threads (padded) */
+    rt_byte             pad02[RT_CACHE_LINE];
+    volatile
+    rt_si32             subs_taken;
+    rt_byte             pad03[RT_CACHE_LINE];
+    /* time of phase 0.5 in sub-trees */
+    rt_time             subs_t;
 
     /* global hierarchical list */
     rt_ELEM            *hlist;
@@ -293,12 +396,27 @@ class rt_Scene : private rt_Registry, public rt_List<rt_Scene>
     rt_ELEM            *slist;
     /* global light/shadow list */
     rt_ELEM            *llist;
+    /* bvnode tree over top-level surfaces of "slist",
+     * surfaces in tree order and bvnodes indexed
+     * by the position of their range's median split,
+     * kept across frames in the scene's heap for refits */
+    rt_si32             tree_num;
+    rt_si32             tree_fit;
+    rt_Surface        **tree_srf;
+    rt_SIMD_SURFACE   **tree_bvb;
+    rt_SIMD_SURFACE   **tree_box;
     /* camera's surface/node list */
     rt_ELEM            *clist;
+    /* reversed copy of camera's list */
+    rt_ELEM            *rlist;
 
     /* ray-position variables */
     rt_vec4             pos;
     rt_vec4             dir;
+    /* camera's pov kept for rendering,
+     * as camera object may change before
+     * pipelined render of the frame */
+    rt_real             pov;
     /* ray-stepper variables */
     rt_vec4             hor;
     rt_vec4             ver;
@@ -309,6 +427,14 @@ class rt_Scene : private rt_Registry, public rt_List<rt_Scene>
     /* tile-stepper variables */
     rt_vec4             htl;
     rt_vec4             vtl;
+    /* camera's tile positioning from
+     * the last reprojection of tile spans */
+    rt_Camera          *tls_cam;
+    rt_vec4             tls_pos;
+    rt_vec4             tls_dir;
+    rt_vec4             tls_nrm;
+    rt_vec4             tls_htl;
+    rt_vec4             tls_vtl;
     /* accumulated ambient color */
     rt_vec4             amb;
 
@@ -325,6 +451,18 @@ class rt_Scene : private rt_Registry, public rt_List<rt_Scene>
     rt_void     reset_pseed();
     rt_void     reset_color();
 
+    rt_bool     srf_slice(rt_si32 index, rt_si32 i, rt_si32 *n);
+    rt_si32     row_slice(rt_si32 index, rt_si32 *k);
+    rt_void     reset_rows();
+    rt_void     reset_lists();
+    rt_void     reset_bufs();
+    rt_void     check_lines();
+    rt_void     release_pools();
+    rt_void     drop_pools();
+    rt_void     init_subs();
+    rt_si32     find_sub(rt_Object *obj);
+    rt_void     set_frame(rt_ui32 *frame);
+
     public:
 
     rt_pntr operator new(size_t size, rt_Heap *hp);
@@ -340,9 +478,19 @@ class rt_Scene : private rt_Registry, public rt_List<rt_Scene>
     rt_void     update(rt_time time, rt_si32 action);
     rt_void     render(rt_time time);
 
+    /* async render into a ring of "num" frames, fence's frame
+     * stays valid until "num" more frames are submitted,
+     * poll/wait throw for fences of frames reused since */
+    rt_si32     set_ring(rt_si32 num);
+    rt_si32     submit(rt_time time);
+    rt_bool     poll(rt_si32 fence);
+    rt_ui32*    wait(rt_si32 fence);
+
     rt_void     update_slice(rt_si32 index, rt_si32 phase);
     rt_void     render_slice(rt_si32 index, rt_si32 phase);
 
+    rt_void     run_async(rt_si32 fence);
+
     rt_void     render_num(rt_si32 x, rt_si32 y,
                            rt_si32 d, rt_si32 z, rt_ui32 num);
 
@@ -353,10 +501,19 @@ class rt_Scene : private rt_Registry, public rt_List<rt_Scene>
     rt_si32     get_x_row();
     rt_void     print_state(); /* has global scope and effect on any instance */
 
+    /* memory usage summed over scene's and threads' heaps */
+    rt_void     get_stats(rt_HEAP_STATS *stats);
+    /* shadow occluder cache lookups and hits summed over threads */
+    rt_void     get_shadow_stats(rt_ui64 *looks, rt_ui64 *hits);
+    /* frames which checked lists and those which kept them */
+    rt_void     get_lists_stats(rt_si32 *looks, rt_si32 *hits);
+
     rt_si32     get_opts();
     rt_si32     set_opts(rt_si32 opts);
     rt_si32     get_pton();
     rt_si32     set_pton(rt_si32 pton);
+    rt_si32     get_pipe();
+    rt_si32     set_pipe(rt_si32 pipe);
 
     rt_si32     get_cam_idx();
     rt_si32     next_cam();
@@ -42,7 +42,8 @@
 #define RT_OPTS_TILING_EXT1     (1 << 2)
 #define RT_OPTS_FSCALE          (1 << 3)
 #define RT_OPTS_TARRAY          (1 << 4)
-#define RT_OPTS_VARRAY          (1 << 5) /* 6 is reserved for future exts */
+#define RT_OPTS_VARRAY          (1 << 5)
+#define RT_OPTS_VARRAY_EXT1     (1 << 6) /* bvnode tree over top surfaces */
 #define RT_OPTS_ADJUST          (1 << 7)
 #define RT_OPTS_UPDATE          (1 << 8)
 #define RT_OPTS_RENDER          (1 << 9)
@@ -59,6 +60,8 @@
 
 #define RT_OPTS_GAMMA           (1 << 20) /* turns off Gamma when set to 1 */
 #define RT_OPTS_FRESNEL         (1 << 21) /* turns off Fresnel when set to 1 */
+#define RT_OPTS_THREAD_EXT1     (1 << 22) /* threads pull tile rows to render */
+#define RT_OPTS_THREAD_EXT2     (1 << 23) /* threads pull surfaces to update */
 
 #define RT_OPTS_BUFFERS         (0 << 24) /* prohibits SIMD-buffers if 1 */
 #define RT_OPTS_PT              (1 << 25) /* prohibits path-tracer if 1 */
@@ -86,11 +89,14 @@
 
 #define RT_OPTS_FULL            (                                           \
         RT_OPTS_THREAD          |                                           \
+        RT_OPTS_THREAD_EXT1     |                                           \
+        RT_OPTS_THREAD_EXT2     |                                           \
         RT_OPTS_TILING          |                                           \
         RT_OPTS_TILING_EXT1     |                                           \
         RT_OPTS_FSCALE          |                                           \
         RT_OPTS_TARRAY          |                                           \
         RT_OPTS_VARRAY          |                                           \
+        RT_OPTS_VARRAY_EXT1     |                                           \
         RT_OPTS_ADJUST          |                                           \
         RT_OPTS_UPDATE          |                                           \
         RT_OPTS_RENDER          |                                           \
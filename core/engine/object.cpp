@@ -170,16 +170,22 @@ rt_void rt_Object::update_bvnode(rt_Object *bvnode, rt_bool mode)
 }
 
 /*
- * Update object's status with given "time", "flags" and "trnode".
+ * Update object's animator with given "time".
  */
-rt_void rt_Object::update_status(rt_time time, rt_si32 flags,
-                                 rt_Object *trnode)
+rt_void rt_Object::update_anim(rt_time time)
 {
     /* animator is called only once for object
      * instances sharing the same scene data,
      * part of sequential update (phase 0.5)
-     * as the code below is not thread-safe */
-    if (obj->f_anim != RT_NULL && obj->time != time)
+     * as the code below is not thread-safe,
+     * when called for all objects before sub-trees
+     * are updated in parallel nothing is written below */
+    if (obj->time == time)
+    {
+        return;
+    }
+
+    if (obj->f_anim != RT_NULL)
     {
         obj->f_anim(time, obj->time < 0 ? 0 : obj->time, trm, RT_NULL);
     }
@@ -188,6 +194,15 @@ rt_void rt_Object::update_status(rt_time time, rt_si32 flags,
      * between first update and all subsequent updates,
      * even if animator is not present */
     obj->time = time;
+}
+
+/*
+ * Update object's status with given "time", "flags" and "trnode".
+ */
+rt_void rt_Object::update_status(rt_time time, rt_si32 flags,
+                                 rt_Object *trnode)
+{
+    update_anim(time);
 
     /* inherit changed status from the hierarchy */
     obj_changed = (flags & RT_UPDATE_FLAG_OBJ);
@@ -617,7 +632,9 @@ rt_Light::rt_Light(rt_Registry *rg, rt_Object *parent, rt_OBJECT *obj) :
     RT_SIMD_SET(s_lgt->a_qdr, lgt->atn[3]);
     RT_SIMD_SET(s_lgt->a_lnr, lgt->atn[2]);
     RT_SIMD_SET(s_lgt->a_cnt, lgt->atn[1] + 1.0f);
-    RT_SIMD_SET(s_lgt->a_rng, lgt->atn[0]);
+    /* range is stored squared, unlimited if not set */
+    RT_SIMD_SET(s_lgt->a_rng, lgt->atn[0] > 0.0f ?
+                              lgt->atn[0] * lgt->atn[0] : RT_INF);
 
     ((rt_Array *)parent)->col.hdr[RT_R] += s_lgt->col_r[0];
     ((rt_Array *)parent)->col.hdr[RT_G] += s_lgt->col_g[0];
@@ -726,13 +743,6 @@ rt_Node::rt_Node(rt_Registry *rg, rt_Object *parent,
     memset(s_srf, 0, ssize);
     s_srf->srf_t[3] = tag;
 
-    /* allocate SIMD-buffers (with actual number of threads) */
-    if ((rg->opts & RT_OPTS_BUFFERS) == 0)
-    {
-        s_srf->msc_p[0] = rg->alloc(RT_BUFFER_POOL*rg->thr_num, RT_SIMD_ALIGN);
-        memset(s_srf->msc_p[0], 255, RT_BUFFER_POOL*rg->thr_num);
-    }
-
 #if 0 /* surface's misc pointers description */
 
     s_srf->srf_t[0];    /* surf ptr, filled in update0 */
@@ -740,7 +750,7 @@ rt_Node::rt_Node(rt_Registry *rg, rt_Object *parent,
     s_srf->srf_t[2];    /* clip ptr, filled in update0 */
     s_srf->srf_t[3];    /* surf tag */
 
-    s_srf->msc_p[0];    /* SIMD-buffers */
+    s_srf->msc_p[0];    /* SIMD-buffers slot offset, filled in Scene */
     s_srf->msc_p[1];    /* surf flg, filled in update0 */
     s_srf->msc_p[2];    /* custom clippers */
     s_srf->msc_p[3];    /* trnode's simd ptr */
@@ -1191,6 +1201,8 @@ rt_Array::rt_Array(rt_Registry *rg, rt_Object *parent,
     /* reset array's changed status */
     arr_changed = 0;
     scn_changed = 0;
+    sub_flags = 0;
+    bnd_done = 0;
 
     /* reset array's accumulated light */
     memset(&col, 0, sizeof(rt_COL));
@@ -1752,23 +1764,66 @@ rt_void rt_Array::update_matrix(rt_mat4 mtx)
  */
 rt_void rt_Array::update_object(rt_time time, rt_si32 flags,
                                 rt_Object *trnode, rt_mat4 mtx)
+{
+    update_head(time, flags, trnode, mtx);
+
+    rt_si32 i;
+
+    /* update every object in array including sub-arrays (recursive) */
+    for (i = 0; i < obj_num; i++)
+    {
+        update_child(time, obj_arr[i], RT_TRUE);
+    }
+
+    update_tail();
+}
+
+/*
+ * Update array itself with given "time", "flags", "trnode" and matrix "mtx",
+ * sub-objects are then updated separately via "update_child",
+ * which allows to split hierarchical update across threads.
+ */
+rt_void rt_Array::update_head(rt_time time, rt_si32 flags,
+                              rt_Object *trnode, rt_mat4 mtx)
 {
     update_status(time, flags, trnode);
 
     update_matrix(mtx);
 
+    /* save array's own transform flags
+     * and changed status for sub-objects */
+    sub_flags = flags | mtx_has_trm | obj_changed;
+}
+
+/*
+ * Update array's sub-object "obj" with given "time",
+ * if "deep" is false only sub-array's head is updated.
+ */
+rt_void rt_Array::update_child(rt_time time, rt_Object *obj, rt_bool deep)
+{
+    /* pass array's own transform flags, changed status,
+     * updated trnode and matrix pointer for sub-objects */
+    if (deep || !RT_IS_ARRAY(obj))
+    {
+        obj->update_object(time, sub_flags, this->trnode, *pmtx);
+    }
+    else
+    {
+        ((rt_Array *)obj)->update_head(time, sub_flags, this->trnode, *pmtx);
+    }
+}
+
+/*
+ * Update array's changed status from already updated sub-objects.
+ */
+rt_void rt_Array::update_tail()
+{
     scn_changed = 0;
 
     rt_si32 i;
 
-    /* update every object in array including sub-arrays (recursive),
-     * pass array's own transform flags, changed status,
-     * updated trnode and matrix pointer for sub-objects */
     for (i = 0; i < obj_num; i++)
     {
-        obj_arr[i]->update_object(time, flags | mtx_has_trm | obj_changed,
-                                  this->trnode, *pmtx);
-
         if (RT_IS_ARRAY(obj_arr[i]))
         {
             scn_changed |= ((rt_Array *)obj_arr[i])->scn_changed;
@@ -1854,7 +1909,7 @@ rt_void rt_Array::update_fields()
  */
 rt_void rt_Array::update_bounds()
 {
-    if (arr_changed == 0)
+    if (arr_changed == 0 || bnd_done != 0)
     {
         return;
     }
@@ -2376,6 +2431,17 @@ rt_Surface::rt_Surface(rt_Registry *rg, rt_Object *parent,
     /* reset surface's changed status */
     srf_changed = 0;
 
+    /* SIMD-buffers slot is assigned by Scene on demand */
+    bfr_slot = -1;
+
+    /* bvnode tree position is assigned by Scene with lists */
+    tree_idx = -1;
+
+    /* tile spans are allocated by Scene once hierarchy is built */
+    tlx = RT_NULL;
+    tlr_min = 0;
+    tlr_max = -1;
+
     /* init outer side material */
     outer = new(rg) rt_Material(rg, &srf->side_outer,
                     obj->obj.pmat_outer ? obj->obj.pmat_outer :
@@ -293,6 +293,8 @@ class rt_Object
     virtual
     rt_void update_bvnode(rt_Object *bvnode, rt_bool mode);
 
+    rt_void update_anim(rt_time time);
+
     virtual
     rt_void update_object(rt_time time, rt_si32 flags,
                           rt_Object *trnode, rt_mat4 mtx);
@@ -458,6 +460,9 @@ class rt_Array : public rt_Node, public rt_List<rt_Array>
     /* scalers matrix */
     rt_mat4             scm;
 
+    /* flags passed to sub-objects */
+    rt_si32             sub_flags;
+
     public:
 
     /* array of objects */
@@ -472,6 +477,10 @@ class rt_Array : public rt_Node, public rt_List<rt_Array>
      * some of its sub-objects changed */
     rt_si32             scn_changed;
 
+    /* non-zero if array's bounds are already updated
+     * in multi-threaded part of phase 2.5 */
+    rt_si32             bnd_done;
+
     /* cumulative luminosity
      * of all lights in array */
     rt_COL              col;
@@ -520,6 +529,12 @@ class rt_Array : public rt_Node, public rt_List<rt_Array>
     virtual
     rt_void update_object(rt_time time, rt_si32 flags,
                           rt_Object *trnode, rt_mat4 mtx);
+
+    rt_void update_head(rt_time time, rt_si32 flags,
+                        rt_Object *trnode, rt_mat4 mtx);
+    rt_void update_child(rt_time time, rt_Object *obj, rt_bool deep);
+    rt_void update_tail();
+
     virtual
     rt_void update_fields();
 
@@ -541,12 +556,12 @@ class rt_Surface : public rt_Node, public rt_List<rt_Surface>
 
     rt_SURFACE         *srf;
 
+    public:
+
     /* non-zero if surface itself or
      * some of its clippers changed */
     rt_si32             srf_changed;
 
-    public:
-
     /* top of the trnode/bvnode
      * sequence on the branch */
     rt_ELEM            *top;
@@ -555,9 +570,22 @@ class rt_Surface : public rt_Node, public rt_List<rt_Surface>
      * where bvnode is not allowed */
     rt_ELEM            *trn;
 
-    /* tiles list in framebuffer
-     * prepared for rendering */
-    rt_ELEM            *tls;
+    /* range of tile-rows with non-empty
+     * tile spans for parallel tiling */
+    rt_si32             tlr_min;
+    rt_si32             tlr_max;
+
+    /* tile spans per tile-row (all mins, then all maxs)
+     * kept across frames unless bounds or camera change */
+    rt_si32            *tlx;
+
+    /* slot in threads' SIMD-buffers,
+     * assigned once surface can receive rays */
+    rt_si32             bfr_slot;
+
+    /* position in scene's bvnode tree,
+     * negative if surface is not in the tree */
+    rt_si32             tree_idx;
 
     /* surface shape extension to
      * bounding box and volume */
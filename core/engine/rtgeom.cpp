@@ -2123,6 +2123,30 @@ rt_si32 bbox_side(rt_BOUND *obj, rt_SHAPE *srf)
     return c;
 }
 
+/*
+ * Determine if "nd1's" bbox is within range "rng"
+ * from "obj's" bbox "mid" (light's "pos").
+ *
+ * Return values:
+ *   0 - no
+ *   1 - yes, also if range is not limited
+ */
+rt_si32 bbox_rang(rt_BOUND *obj, rt_BOUND *nd1, rt_real rng)
+{
+    /* check if range is limited and node has bounds */
+    if (rng <= 0.0f || nd1->rad == RT_INF)
+    {
+        return 1;
+    }
+
+    /* check if bounding sphere is beyond range */
+    rt_vec4 nd1_vec;
+    RT_VEC3_SUB(nd1_vec, nd1->mid, obj->mid);
+    rt_real nd1_len = RT_VEC3_LEN(nd1_vec);
+
+    return nd1_len - nd1->rad <= rng;
+}
+
 /******************************************************************************/
 /******************************************************************************/
 /******************************************************************************/
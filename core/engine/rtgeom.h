@@ -363,6 +363,16 @@ rt_si32 bbox_sort(rt_BOUND *obj, rt_BOUND *nd1, rt_BOUND *nd2);
  */
 rt_si32 bbox_side(rt_BOUND *obj, rt_SHAPE *srf);
 
+/*
+ * Determine if "nd1's" bbox is within range "rng"
+ * from "obj's" bbox "mid" (light's "pos").
+ *
+ * Return values:
+ *   0 - no
+ *   1 - yes, also if range is not limited
+ */
+rt_si32 bbox_rang(rt_BOUND *obj, rt_BOUND *nd1, rt_real rng);
+
 #endif /* RT_RTGEOM_H */
 
 /******************************************************************************/
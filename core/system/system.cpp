@@ -8,6 +8,18 @@
 #include <stdio.h>
 #endif /* RT_EMBED_STDOUT */
 
+#include <string.h>
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#if (defined __linux__)
+#include <stdio.h>
+#include <pthread.h>
+#include <sched.h>
+#endif /* __linux__ */
+
 #include "system.h"
 
 /******************************************************************************/
@@ -18,7 +30,8 @@
  * system.cpp: Implementation of the system layer.
  *
  * System layer of the engine responsible for file I/O operations,
- * fast linear memory heap allocations, error and info logging
+ * fast linear memory heap allocations, error and info logging,
+ * built-in thread pool (used if the platform doesn't provide one)
  * as well as definitions of List template and Exception classes.
  */
 
@@ -153,37 +166,101 @@ rt_Heap::rt_Heap(rt_FUNC_ALLOC f_alloc, rt_FUNC_FREE f_free)
     /* init heap */
     head = RT_NULL;
     obj_head = RT_NULL;
+    spare = RT_NULL;
+    spare_size = 0;
+    memset(&stats, 0, sizeof(rt_HEAP_STATS));
     chunk_alloc(0, RT_ALIGN);
 }
 
 /*
  * Allocate new chunk at least "size" bytes with given "align",
  * and link it to the list as head.
+ * Spare chunks are reused first, as heap is only used by one thread at a time
+ * this avoids locking in platform's alloc for per-frame allocs.
+ * Allocs start past the cache line of chunk's header and end a cache line
+ * before its end, thus heaps of different threads never share cache lines.
  */
 rt_void rt_Heap::chunk_alloc(rt_size size, rt_ui32 align)
 {
     /* compute align and new chunk's size */
     rt_size mask = align > 0 ? align - 1 : 0;
-    rt_size real_size = size + mask + sizeof(rt_CHUNK) + (RT_CHUNK_SIZE - 1);
+    rt_size line = RT_MAX(mask, RT_CACHE_LINE - 1);
+    rt_size real_size = size + line + sizeof(rt_CHUNK) + RT_CACHE_LINE +
+                                                        (RT_CHUNK_SIZE - 1);
     real_size = (real_size / RT_CHUNK_SIZE) * RT_CHUNK_SIZE;
-    rt_CHUNK *chunk = (rt_CHUNK *)f_alloc(real_size);
 
-    /* check for out of memory */
+#if RT_HUGEPAGE != 0
+    /* round large chunks up to huge page granularity, platform's alloc
+     * backs such chunks with huge pages (checked by RT_CHUNK_IS_HUGE) */
+    if (real_size >= RT_CHUNK_HUGE)
+    {
+        real_size += RT_CHUNK_HUGE - 1;
+        real_size = (real_size / RT_CHUNK_HUGE) * RT_CHUNK_HUGE;
+    }
+#endif /* RT_HUGEPAGE */
+    rt_CHUNK *chunk = RT_NULL, **ptr = &spare;
+
+    /* search spare chunks, first fit */
+    while (*ptr != RT_NULL)
+    {
+        if ((*ptr)->size >= real_size)
+        {
+            chunk = *ptr;
+            *ptr = chunk->next;
+            spare_size -= chunk->size;
+            real_size = chunk->size;
+            break;
+        }
+
+        ptr = &(*ptr)->next;
+    }
+
     if (chunk == RT_NULL)
     {
-        throw rt_Exception("out of memory in heap's chunk_alloc");
+        chunk = (rt_CHUNK *)f_alloc(real_size);
+
+        /* check for out of memory */
+        if (chunk == RT_NULL)
+        {
+            throw rt_Exception("out of memory in heap's chunk_alloc");
+        }
+
+        stats.total += real_size;
+        stats.chunks++;
     }
 
     /* prepare new chunk */
     chunk->ptr = (rt_byte *)chunk + sizeof(rt_CHUNK);
-    chunk->ptr = (rt_byte *)(((rt_size)chunk->ptr + mask) & ~mask);
-    chunk->end = (rt_byte *)chunk + real_size;
+    chunk->ptr = (rt_byte *)(((rt_size)chunk->ptr + line) & ~line);
+    chunk->end = (rt_byte *)chunk + real_size - RT_CACHE_LINE;
     chunk->size = real_size;
     chunk->next = head;
 
     head = chunk;
 }
 
+/*
+ * Keep released chunk for reuse if it fits into spare limit,
+ * return it to the platform otherwise.
+ * Spare chunks come from platform's alloc, thus stay within its address range.
+ */
+rt_void rt_Heap::chunk_free(rt_CHUNK *chunk)
+{
+    if (spare_size + chunk->size <= RT_CHUNK_KEEP)
+    {
+        chunk->next = spare;
+        spare = chunk;
+        spare_size += chunk->size;
+    }
+    else
+    {
+        stats.total -= chunk->size;
+        stats.chunks--;
+
+        f_free(chunk, chunk->size);
+    }
+}
+
 /*
  * Reserve given "size" bytes of memory with given "align",
  * move heap pointer ahead for the next alloc.
@@ -207,9 +284,13 @@ rt_pntr rt_Heap::reserve(rt_size size, rt_ui32 align)
     rt_size mask = align > 0 ? align - 1 : 0;
     rt_byte *ptr = (rt_byte *)(((rt_size)head->ptr + mask) & ~mask);
 
-    /* allocate bigger chunk, if current doesn't fit */
+    /* allocate bigger chunk, if current doesn't fit,
+     * current chunk's tail is left unused */
     if (head->end < ptr + size)
     {
+        stats.waste += head->end - head->ptr;
+        stats.grows++;
+
         chunk_alloc(size, align);
         ptr = head->ptr;
     }
@@ -228,10 +309,17 @@ rt_pntr rt_Heap::reserve(rt_size size, rt_ui32 align)
  */
 rt_pntr rt_Heap::release(rt_pntr ptr)
 {
+    stats.used = 0;
+    stats.span_grows = 0;
+
     /* search chunk where "ptr" belongs,
      * free chunks allocated afterwards */
     while (head != RT_NULL && (ptr < head + 1 || ptr >= head->end))
     {
+        /* count chunk's part of the span */
+        stats.used += head->ptr - (rt_byte *)(head + 1);
+        stats.span_grows++;
+
         rt_pntr *obj = &obj_head;
 
         /* traverse the list of free objects */
@@ -251,13 +339,18 @@ rt_pntr rt_Heap::release(rt_pntr ptr)
 
         /* release chunk */
         rt_CHUNK *chunk = head->next;
-        f_free(head, head->size);
+        chunk_free(head);
         head = chunk;
     }
 
     /* reset heap pointer to "ptr" */
     if (head != RT_NULL && ptr >= head + 1 && ptr < head->end)
     {
+        /* count chunk's part of the span, update high-water mark */
+        stats.used += head->ptr - (rt_byte *)ptr;
+        stats.peak = RT_MAX(stats.peak, stats.used);
+        stats.spans++;
+
         rt_pntr *obj = &obj_head;
 
         /* traverse the list of free objects */
@@ -353,6 +446,14 @@ rt_pntr rt_Heap::obj_free(rt_pntr ptr)
     return RT_NULL;
 }
 
+/*
+ * Copy heap's usage counters to "stats".
+ */
+rt_void rt_Heap::get_stats(rt_HEAP_STATS *stats)
+{
+    *stats = this->stats;
+}
+
 /*
  * Deinitialize heap.
  */
@@ -372,6 +473,437 @@ rt_Heap::~rt_Heap()
         f_free(head, head->size);
         head = chunk;
     }
+
+    /* free all spare chunks */
+    while (spare != RT_NULL)
+    {
+        rt_CHUNK *chunk = spare->next;
+        f_free(spare, spare->size);
+        spare = chunk;
+    }
+}
+
+/******************************************************************************/
+/*******************************   THREAD POOL   ******************************/
+/******************************************************************************/
+
+/*
+ * Job in the pool's queue, "seq" - job's number + 1 when posted,
+ * "fin" - when all threads are done, "rel" - when the poster is done,
+ * all three advance by RT_POOL_QUEUE every time the slot is reused.
+ */
+struct rt_POOL_JOB
+{
+    rt_FUNC_SLICE       f_slice; /* NULL - terminate */
+    rt_pntr             data;
+    rt_si32             cmd;
+    rt_si32             own; /* 0 - posted, released by the last thread */
+    rt_pstr             err; /* first error thrown by slices */
+    volatile rt_ui32    seq;
+    volatile rt_ui32    fin;
+    volatile rt_ui32    rel;
+    volatile rt_si32    left; /* threads left to finish the job */
+};
+
+/*
+ * Pool's threads, job-queue and sync objects,
+ * "park" - number of threads sleeping on each of the conds.
+ */
+struct rt_POOL_DATA
+{
+    std::thread        *thread;
+    rt_POOL_JOB         job[RT_POOL_QUEUE];
+    volatile rt_ui32    tail; /* number of jobs posted so far */
+    volatile rt_si32    park[2];
+    std::mutex          lock;
+    std::condition_variable cond[2];
+};
+
+/*
+ * Return number of CPUs available to the process.
+ */
+rt_si32 rt_ThreadPool::get_cpus()
+{
+    rt_si32 n = 0;
+
+#if (defined __linux__)
+    cpu_set_t cpuset;
+    if (sched_getaffinity(0, sizeof(cpu_set_t), &cpuset) == 0)
+    {
+        n = CPU_COUNT(&cpuset);
+    }
+#endif /* __linux__ */
+
+    if (n == 0)
+    {
+        n = (rt_si32)std::thread::hardware_concurrency();
+    }
+
+    return RT_MAX(n, 1);
+}
+
+#if (defined __linux__)
+
+/*
+ * Read list of CPUs (or nodes) in "0-3,8,10-11" format from /sys file "name",
+ * return number of entries found.
+ */
+static
+rt_si32 read_cpulist(rt_pstr name, cpu_set_t *set)
+{
+    rt_si32 a, b, c = ',', k = 0;
+
+    CPU_ZERO(set);
+
+    FILE *f = fopen(name, "r");
+
+    if (f == NULL)
+    {
+        return 0;
+    }
+
+    while (c == ',' && fscanf(f, "%d", &a) == 1)
+    {
+        b = a;
+        c = fgetc(f);
+
+        if (c == '-' && fscanf(f, "%d", &b) == 1)
+        {
+            c = fgetc(f);
+        }
+
+        for (; a <= b && a < CPU_SETSIZE; a++, k++)
+        {
+            CPU_SET(a, set);
+        }
+    }
+
+    fclose(f);
+
+    return k;
+}
+
+/*
+ * Order CPUs from process affinity mask "cpuset_pr" node by node
+ * using NUMA topology from /sys, so that consecutive threads share a node,
+ * return number of CPUs written to "cpus".
+ */
+static
+rt_si32 numa_order(cpu_set_t *cpuset_pr, rt_si32 *cpus)
+{
+    cpu_set_t nodes, cpuset_nd, cpuset_dn;
+    rt_char name[64];
+    rt_si32 a, n, k = 0;
+
+    CPU_ZERO(&cpuset_dn);
+
+    if (read_cpulist((rt_pstr)"/sys/devices/system/node/online", &nodes) > 0)
+    {
+        for (n = 0; n < CPU_SETSIZE; n++)
+        {
+            if (!CPU_ISSET(n, &nodes))
+            {
+                continue;
+            }
+
+            sprintf(name, "/sys/devices/system/node/node%d/cpulist", n);
+            read_cpulist(name, &cpuset_nd);
+
+            for (a = 0; a < CPU_SETSIZE; a++)
+            {
+                if (CPU_ISSET(a, &cpuset_nd) && CPU_ISSET(a, cpuset_pr)
+                && !CPU_ISSET(a, &cpuset_dn))
+                {
+                    CPU_SET(a, &cpuset_dn);
+                    cpus[k++] = a;
+                }
+            }
+        }
+    }
+
+    /* CPUs not listed under any node keep their original order */
+    for (a = 0; a < CPU_SETSIZE; a++)
+    {
+        if (CPU_ISSET(a, cpuset_pr) && !CPU_ISSET(a, &cpuset_dn))
+        {
+            cpus[k++] = a;
+        }
+    }
+
+    return k;
+}
+
+#endif /* __linux__ */
+
+/*
+ * Instantiate pool of "thnum" threads (<= 0 - all CPUs),
+ * which spin for "spin" iterations before parking.
+ */
+rt_ThreadPool::rt_ThreadPool(rt_si32 thnum, rt_si32 spin)
+{
+    rt_si32 i;
+
+    this->thnum = thnum > 0 ? thnum : get_cpus();
+    this->spin = RT_MAX(spin, 0);
+
+    pdata = new rt_POOL_DATA;
+
+    pdata->tail = 0;
+    pdata->park[0] = 0;
+    pdata->park[1] = 0;
+
+    /* slots look finished and released
+     * by jobs from before the first round */
+    for (i = 0; i < RT_POOL_QUEUE; i++)
+    {
+        rt_POOL_JOB *job = &pdata->job[i];
+
+        job->f_slice = RT_NULL;
+        job->data = RT_NULL;
+        job->cmd = 0;
+        job->own = 1;
+        job->err = RT_NULL;
+        job->seq = i + 1 - RT_POOL_QUEUE;
+        job->fin = i + 1 - RT_POOL_QUEUE;
+        job->rel = i + 1 - RT_POOL_QUEUE;
+        job->left = 0;
+    }
+
+#if (defined __linux__)
+    /* threads are pinned to CPUs of the process node by node,
+     * as the engine gives consecutive threads adjacent blocks
+     * of the frame, unless there are more threads than CPUs */
+    cpu_set_t cpuset_pr, cpuset_th;
+    sched_getaffinity(0, sizeof(cpu_set_t), &cpuset_pr);
+    rt_si32 cpus[CPU_SETSIZE];
+    rt_bool pin = numa_order(&cpuset_pr, cpus) >= this->thnum;
+#endif /* __linux__ */
+
+    pdata->thread = new std::thread[this->thnum];
+
+    for (i = 0; i < this->thnum; i++)
+    {
+        pdata->thread[i] = std::thread(&rt_ThreadPool::worker, this, i);
+
+#if (defined __linux__)
+        if (pin)
+        {
+            CPU_ZERO(&cpuset_th);
+            CPU_SET(cpus[i], &cpuset_th);
+            pthread_setaffinity_np(pdata->thread[i].native_handle(),
+                                   sizeof(cpu_set_t), &cpuset_th);
+        }
+#endif /* __linux__ */
+    }
+}
+
+/*
+ * Wait until counter "*val" (only advancing) reaches "ref",
+ * spin for the given number of iterations before parking on "k"-th cond.
+ */
+rt_void rt_ThreadPool::wait(volatile rt_ui32 *val, rt_ui32 ref, rt_si32 k)
+{
+    rt_si32 i;
+
+    for (i = 0; i < spin; i++)
+    {
+        if ((rt_si32)(*val - ref) >= 0)
+        {
+            return;
+        }
+    }
+
+    std::unique_lock<std::mutex> lk(pdata->lock);
+    /* full barrier in atomic add orders "park" store before "val" load */
+    RT_ATOMIC_ADD(&pdata->park[k], +1);
+    while ((rt_si32)(*val - ref) < 0)
+    {
+        pdata->cond[k].wait(lk);
+    }
+    RT_ATOMIC_ADD(&pdata->park[k], -1);
+}
+
+/*
+ * Wake threads parked on "k"-th cond,
+ * counter must be updated with atomic add (full barrier) before the call.
+ */
+rt_void rt_ThreadPool::wake(rt_si32 k)
+{
+    if (pdata->park[k] != 0)
+    {
+        std::lock_guard<std::mutex> lk(pdata->lock);
+        pdata->cond[k].notify_all();
+    }
+}
+
+/*
+ * Worker thread's loop,
+ * every thread runs every job in the order they were posted.
+ */
+rt_void rt_ThreadPool::worker(rt_si32 index)
+{
+    rt_ui32 n = 0;
+
+    while (1)
+    {
+        rt_POOL_JOB *job = &pdata->job[n & (RT_POOL_QUEUE - 1)];
+
+        n++;
+        wait(&job->seq, n, 0);
+
+        rt_FUNC_SLICE f_slice = job->f_slice;
+
+        /* if one thread throws an exception,
+         * other threads still finish their slices,
+         * first error is passed on to the poster */
+        if (f_slice != RT_NULL)
+        try
+        {
+            f_slice(job->data, index, job->cmd);
+        }
+        catch (rt_Exception e)
+        {
+            std::lock_guard<std::mutex> lk(pdata->lock);
+            if (job->err == RT_NULL)
+            {
+                job->err = e.err;
+            }
+        }
+
+        if (RT_ATOMIC_ADD(&job->left, -1) == 1)
+        {
+            rt_si32 own = job->own;
+
+            RT_ATOMIC_ADD(&job->fin, RT_POOL_QUEUE);
+
+            /* release the slot of posted job for the next job,
+             * as its poster doesn't wait for it */
+            if (own == 0)
+            {
+                RT_ATOMIC_ADD(&job->rel, RT_POOL_QUEUE);
+            }
+            wake(1);
+        }
+
+        if (f_slice == RT_NULL)
+        {
+            break;
+        }
+    }
+}
+
+/*
+ * Post job to run "f_slice" on every thread of the pool,
+ * block until finished, pass on exception thrown by any of the slices.
+ * Can be called from several threads at the same time.
+ */
+rt_void rt_ThreadPool::run(rt_FUNC_SLICE f_slice, rt_pntr data, rt_si32 cmd)
+{
+    rt_ui32 n = RT_ATOMIC_ADD(&pdata->tail, 1);
+    rt_POOL_JOB *job = &pdata->job[n & (RT_POOL_QUEUE - 1)];
+
+    /* wait for the previous job in the slot to be released */
+    wait(&job->rel, n + 1 - RT_POOL_QUEUE, 1);
+
+    job->f_slice = f_slice;
+    job->data = data;
+    job->cmd = cmd;
+    job->own = 1;
+    job->err = RT_NULL;
+    job->left = thnum;
+
+    /* signal all threads to run the job */
+    RT_ATOMIC_ADD(&job->seq, RT_POOL_QUEUE);
+    wake(0);
+    /* wait for all threads to finish */
+    wait(&job->fin, n + 1, 1);
+
+    rt_pstr err = job->err;
+
+    /* release the slot for the next job */
+    RT_ATOMIC_ADD(&job->rel, RT_POOL_QUEUE);
+    wake(1);
+
+    if (err != RT_NULL)
+    {
+        throw rt_Exception(err);
+    }
+}
+
+/*
+ * Post job to run "f_slice" on every thread of the pool without waiting,
+ * return job's number for "done" and "sync". Slices of posted jobs
+ * must not throw, as there is no poster to pass the exception on to.
+ * Blocks only while all slots of the job-queue are in flight.
+ */
+rt_ui32 rt_ThreadPool::post(rt_FUNC_SLICE f_slice, rt_pntr data, rt_si32 cmd)
+{
+    rt_ui32 n = RT_ATOMIC_ADD(&pdata->tail, 1);
+    rt_POOL_JOB *job = &pdata->job[n & (RT_POOL_QUEUE - 1)];
+
+    /* wait for the previous job in the slot to be released */
+    wait(&job->rel, n + 1 - RT_POOL_QUEUE, 1);
+
+    job->f_slice = f_slice;
+    job->data = data;
+    job->cmd = cmd;
+    job->own = 0;
+    job->err = RT_NULL;
+    job->left = thnum;
+
+    /* signal all threads to run the job */
+    RT_ATOMIC_ADD(&job->seq, RT_POOL_QUEUE);
+    wake(0);
+
+    return n;
+}
+
+/*
+ * Return true if job with a given number is finished,
+ * only advancing counters are compared, thus slot's reuse is safe.
+ */
+rt_bool rt_ThreadPool::done(rt_ui32 job)
+{
+    rt_POOL_JOB *jb = &pdata->job[job & (RT_POOL_QUEUE - 1)];
+
+    return (rt_si32)(jb->fin - (job + 1)) >= 0 ? RT_TRUE : RT_FALSE;
+}
+
+/*
+ * Wait for job with a given number to finish.
+ */
+rt_void rt_ThreadPool::sync(rt_ui32 job)
+{
+    rt_POOL_JOB *jb = &pdata->job[job & (RT_POOL_QUEUE - 1)];
+
+    wait(&jb->fin, job + 1, 1);
+}
+
+/*
+ * Return number of threads in the pool.
+ */
+rt_si32 rt_ThreadPool::get_thnum()
+{
+    return thnum;
+}
+
+/*
+ * Deinitialize pool after all threads are done with posted jobs.
+ */
+rt_ThreadPool::~rt_ThreadPool()
+{
+    rt_si32 i;
+
+    /* signal all threads to terminate */
+    run(RT_NULL, RT_NULL, 0);
+
+    for (i = 0; i < thnum; i++)
+    {
+        pdata->thread[i].join();
+    }
+
+    delete [] pdata->thread;
+    delete pdata;
 }
 
 /******************************************************************************/
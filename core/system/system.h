@@ -30,6 +30,18 @@
 /******************************************************************************/
 
 #define RT_CHUNK_SIZE           65536 /* heap allocation granularity (16*4k) */
+#define RT_CHUNK_KEEP           (16*RT_CHUNK_SIZE) /* spare chunks per heap */
+#define RT_CHUNK_HUGE           (32*RT_CHUNK_SIZE) /* huge page granularity */
+#define RT_CACHE_LINE           128 /* false sharing granularity (line pairs) */
+
+#ifndef RT_HUGEPAGE
+#define RT_HUGEPAGE             0  /* 1 - transparent, 2 - explicit (hugetlb) */
+#endif /* RT_HUGEPAGE */
+
+/* heap's chunks rounded to huge page granularity, the only check
+ * for platform's alloc/free to back such chunks with huge pages */
+#define RT_CHUNK_IS_HUGE(size)                                              \
+        (RT_HUGEPAGE != 0 && (size) % RT_CHUNK_HUGE == 0)
 
 #define RT_PATH_STRFY(p)        #p
 #define RT_PATH_TOSTR(p)        RT_PATH_STRFY(p)
@@ -47,6 +59,7 @@ template <class rt_Class>
 class rt_List;
 
 class rt_Exception;
+class rt_ThreadPool;
 class rt_LogRedirect;
 
 /******************************************************************************/
@@ -98,6 +111,22 @@ struct rt_CHUNK
     rt_CHUNK           *next;
 };
 
+/*
+ * Heap statistics, "used" and "span_grows" are updated on every release
+ * for the span of allocs made after the released checkpoint (per-frame).
+ */
+struct rt_HEAP_STATS
+{
+    rt_size             used;       /* bytes used by the last released span */
+    rt_size             peak;       /* high-water mark of released spans */
+    rt_size             waste;      /* tail bytes left in overflowed chunks */
+    rt_size             total;      /* bytes in chunks held (incl. spare) */
+    rt_si32             chunks;     /* chunks held (incl. spare) */
+    rt_si32             grows;      /* overflow events (new head chunks) */
+    rt_si32             spans;      /* number of released spans */
+    rt_si32             span_grows; /* overflow events in the last span */
+};
+
 /*
  * Memory alloc/free function types.
  */
@@ -117,7 +146,16 @@ class rt_Heap
     rt_CHUNK           *head;
     rt_pntr             obj_head;
 
+    /* released chunks kept for reuse,
+     * up to RT_CHUNK_KEEP bytes in total */
+    rt_CHUNK           *spare;
+    rt_size             spare_size;
+
+    /* usage counters */
+    rt_HEAP_STATS       stats;
+
     rt_void chunk_alloc(rt_size size, rt_ui32 align);
+    rt_void chunk_free(rt_CHUNK *chunk);
 
     protected:
 
@@ -139,6 +177,8 @@ class rt_Heap
 
     rt_pntr obj_alloc(rt_size size, rt_ui32 align);
     rt_pntr obj_free(rt_pntr ptr);
+
+    rt_void get_stats(rt_HEAP_STATS *stats);
 };
 
 /******************************************************************************/
@@ -190,6 +230,63 @@ class rt_Exception
    ~rt_Exception() { }
 };
 
+/******************************************************************************/
+/*******************************   THREAD POOL   ******************************/
+/******************************************************************************/
+
+#define RT_POOL_QUEUE           16 /* jobs in flight per pool (power of 2) */
+#define RT_POOL_SPIN            1024 /* spins before parking (0 - at once) */
+
+/*
+ * Slice function type, run by every thread of the pool with its "index".
+ */
+typedef rt_void (*rt_FUNC_SLICE)(rt_pntr data, rt_si32 index, rt_si32 cmd);
+
+struct rt_POOL_DATA;
+
+/*
+ * ThreadPool runs every job as a set of slices on its pinned worker threads,
+ * jobs can be posted from several threads at the same time.
+ */
+class rt_ThreadPool
+{
+/*  fields */
+
+    private:
+
+    /* number of threads and
+     * spin iterations before parking */
+    rt_si32             thnum;
+    rt_si32             spin;
+    /* threads, job-queue and sync objects */
+    rt_POOL_DATA       *pdata;
+
+/*  methods */
+
+    private:
+
+    rt_void worker(rt_si32 index);
+    rt_void wait(volatile rt_ui32 *val, rt_ui32 ref, rt_si32 k);
+    rt_void wake(rt_si32 k);
+
+    public:
+
+    rt_ThreadPool(rt_si32 thnum, rt_si32 spin); /* thnum <= 0 - all CPUs */
+
+    virtual
+   ~rt_ThreadPool();
+
+    rt_si32 get_thnum();
+    rt_void run(rt_FUNC_SLICE f_slice, rt_pntr data, rt_si32 cmd);
+
+    rt_ui32 post(rt_FUNC_SLICE f_slice, rt_pntr data, rt_si32 cmd);
+    rt_bool done(rt_ui32 job);
+    rt_void sync(rt_ui32 job);
+
+    static
+    rt_si32 get_cpus();
+};
+
 /******************************************************************************/
 /*********************************   LOGGING   ********************************/
 /******************************************************************************/
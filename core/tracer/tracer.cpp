@@ -57,6 +57,7 @@
 #define RT_FEAT_LIGHTS_COLORED      1
 #define RT_FEAT_LIGHTS_AMBIENT      1
 #define RT_FEAT_LIGHTS_SHADOWS      1
+#define RT_FEAT_LIGHTS_OCCLUDER     1   /* test last occluder of light first */
 #define RT_FEAT_LIGHTS_DIFFUSE      1
 #define RT_FEAT_LIGHTS_ATTENUATION  1
 #define RT_FEAT_LIGHTS_SPECULAR     1
@@ -129,7 +130,7 @@
 #define LST   0x08 /* LOCAL, PARAM */
 #define CLP   0x08 /* MSC_P, SRF_T */
 
-#define OBJ   0x0C /* LOCAL, PARAM, MSC_P */
+#define OBJ   0x0C /* LOCAL, PARAM, MAT_P, MSC_P */
 #define TAG   0x0C /* SRF_T, XMISC */
 
 /*
@@ -790,8 +791,7 @@
                  EQ_x, 100501f)                                             \
         movyx_mi(Mecx, ctx_TMASK(0x##pn), IB(0))                            \
         stack_st(Rebx)                                                      \
-        movxx_ld(Rebx, Mebp, inf_THNDX)                                     \
-        mulxx_ri(Rebx, IV(RT_BUFFER_POOL))                                  \
+        movxx_ld(Rebx, Mebp, inf_BFR_P)                                     \
         movyx_ld(Redx, Mecx, ctx_SRF_S(0x##pn))                             \
         mulwx_ri(Redx, IV(RT_BUFFER_POOL / 2))                              \
         movxx_ri(Reax, IH(RT_BUFFER_SIZE))                                  \
@@ -2144,7 +2144,7 @@ rt_void render0(rt_SIMD_INFOX *s_inf)
 
 #if RT_FEAT_MULTITHREADING
 
-        movxx_ld(Reax, Mebp, inf_THNDX)
+        movxx_ld(Reax, Mebp, inf_ROW_S)
         movxx_st(Reax, Mebp, inf_FRM_Y)
 
 #else /* RT_FEAT_MULTITHREADING */
@@ -2156,7 +2156,11 @@ rt_void render0(rt_SIMD_INFOX *s_inf)
     LBL(770676) /* YY_cyc */
 
         movxx_ld(Reax, Mebp, inf_FRM_Y)
+#if RT_FEAT_MULTITHREADING
+        cmjxx_rm(Reax, Mebp, inf_ROW_E,
+#else /* RT_FEAT_MULTITHREADING */
         cmjxx_rm(Reax, Mebp, inf_FRM_H,
+#endif /* RT_FEAT_MULTITHREADING */
                  LT_x, 770191f) /* YY_ini */
 
         jmpxx_lb(770923f) /* YY_out */
@@ -4035,6 +4039,24 @@ rt_void render0(rt_SIMD_INFOX *s_inf)
         xorpx_rr(Xmm7, Xmm7)                    /* tmp_v <-     0 */
         cltps_rr(Xmm7, Xmm0)                    /* tmp_v <! r_dot */
         andpx_ld(Xmm7, Mecx, ctx_TMASK(0))      /* lmask &= TMASK */
+
+#if RT_FEAT_LIGHTS_ATTENUATION
+
+        /* cut light off beyond its range,
+         * matches culling of surfaces' light lists */
+        movpx_ld(Xmm4, Mecx, ctx_NEW_X(0))
+        mulps_rr(Xmm4, Xmm4)
+        movpx_ld(Xmm5, Mecx, ctx_NEW_Y(0))
+        mulps_rr(Xmm5, Xmm5)
+        movpx_ld(Xmm6, Mecx, ctx_NEW_Z(0))
+        mulps_rr(Xmm6, Xmm6)
+        addps_rr(Xmm4, Xmm5)
+        addps_rr(Xmm4, Xmm6)
+        cleps_ld(Xmm4, Medx, lgt_A_RNG)         /* r^2 <= A_RNG */
+        andpx_rr(Xmm7, Xmm4)                    /* lmask &= rmask */
+
+#endif /* RT_FEAT_LIGHTS_ATTENUATION */
+
         CHECK_MASK(230538f, NONE, Xmm7)         /* LT_amb */
 
 #if RT_FEAT_LIGHTS_SHADOWS
@@ -4072,6 +4094,47 @@ rt_void render0(rt_SIMD_INFOX *s_inf)
         movpx_st(Xmm0, Mecx, ctx_LOCAL(-C/2 + RT_SIMD_QUADS*8))
 
         movxx_ld(Resi, Medi, elm_DATA)          /* load shadow list */
+
+#if RT_FEAT_LIGHTS_OCCLUDER
+
+        /* look up thread's occluder cache slot
+         * hashed by light element, slot's TEMP holds the key,
+         * slot's SIMD holds the light's last occluder if any */
+        movxx_ld(Redx, Mebp, inf_SHW_P)
+        cmjxx_rz(Redx,
+                 EQ_x, 230162f) /* LT_shn */
+        cmjxx_rz(Resi,
+                 EQ_x, 230162f) /* LT_shn */
+
+        movxx_rr(Reax, Redi)
+        shrxx_ri(Reax, IB(3+P))
+        andxx_ld(Reax, Mebp, inf_SHW_M)
+        shlxx_ri(Reax, IB(3+P))
+        addxx_rr(Redx, Reax)                    /* Redx <- slot */
+
+        addxx_mi(Mebp, inf_SHW_L, IB(1))        /* count cache lookups */
+
+        cmjxx_rm(Redi, Medx, elm_TEMP,
+                 EQ_x, 230161f) /* LT_shk */
+
+        movxx_st(Redi, Medx, elm_TEMP)          /* claim slot for light */
+        movxx_mi(Medx, elm_SIMD, IB(0))         /* with no occluder yet */
+        jmpxx_lb(230162f) /* LT_shn */
+
+    LBL(230161) /* LT_shk */
+
+        cmjxx_mz(Medx, elm_SIMD,
+                 EQ_x, 230162f) /* LT_shn */
+
+        /* test cached occluder first,
+         * then continue with the whole shadow list */
+        movxx_st(Resi, Medx, elm_NEXT)
+        movxx_rr(Resi, Redx)
+
+    LBL(230162) /* LT_shn */
+
+#endif /* RT_FEAT_LIGHTS_OCCLUDER */
+
         jmpxx_lb(990676b) /* OO_cyc */
 
     LBL(230153) /* LT_ret */
@@ -6685,6 +6748,57 @@ rt_void render0(rt_SIMD_INFOX *s_inf)
 
     LBL(990923) /* OO_out */
 
+#if RT_FEAT_LIGHTS_OCCLUDER
+
+        CHECK_FLAG(990532f, PARAM, RT_FLAG_SHAD) /* OO_shn */
+
+        /* all rays within SIMD are in the shadow
+         * if shadow list isn't exhausted,
+         * then "Resi" holds the last occluder */
+        cmjxx_rz(Resi,
+                 EQ_x, 990532f) /* OO_shn */
+        movxx_ld(Redx, Mebp, inf_SHW_P)
+        cmjxx_rz(Redx,
+                 EQ_x, 990532f) /* OO_shn */
+
+        movxx_ld(Reax, Mecx, ctx_PARAM(LST))
+        shrxx_ri(Reax, IB(3+P))
+        andxx_ld(Reax, Mebp, inf_SHW_M)
+        shlxx_ri(Reax, IB(3+P))
+        addxx_rr(Redx, Reax)                    /* Redx <- slot */
+
+        cmjxx_rr(Resi, Redx,
+                 NE_x, 990531f) /* OO_shr */
+
+        addxx_mi(Mebp, inf_SHW_H, IB(1))        /* count cache hits */
+        jmpxx_lb(990532f) /* OO_shn */
+
+    LBL(990531) /* OO_shr */
+
+        /* only cache surfaces which can be tested
+         * apart from trnode's list and are opaque
+         * for shadows on both sides, as testing
+         * them twice doesn't change the result */
+        movxx_ld(Rebx, Mesi, elm_SIMD)
+        movxx_ld(Reax, Mebx, srf_MSC_P(OBJ))    /* load trnode's simd ptr */
+        cmjxx_rz(Reax,
+                 EQ_x, 990533f) /* OO_shs */
+        cmjxx_rr(Reax, Rebx,
+                 NE_x, 990532f) /* OO_shn */
+
+    LBL(990533) /* OO_shs */
+
+        movxx_ld(Reax, Mebx, srf_MAT_P(FLG))
+        orrxx_ld(Reax, Mebx, srf_MAT_P(OBJ))
+        arjxx_ri(Reax, IH(RT_PROP_TRANSP | RT_PROP_LIGHT),
+        and_x,   NZ_x, 990532f) /* OO_shn */
+
+        movxx_st(Rebx, Medx, elm_SIMD)          /* update cached occluder */
+
+    LBL(990532) /* OO_shn */
+
+#endif /* RT_FEAT_LIGHTS_OCCLUDER */
+
 #if RT_FEAT_BUFFERS
 
         CHECK_FLAG(990521f, PARAM, RT_FLAG_SHAD) /* OO_spr */
@@ -6832,8 +6946,7 @@ rt_void render0(rt_SIMD_INFOX *s_inf)
 
     LBL(990331) /* OO_mtr */
 
-        movxx_ld(Rebx, Mebp, inf_THNDX)
-        mulxx_ri(Rebx, IV(RT_BUFFER_POOL))
+        movxx_ld(Rebx, Mebp, inf_BFR_P)
         movwx_ri(Redx, IB(RT_FLAG_SIDE_OUTER))
         mulwx_ri(Redx, IV(RT_BUFFER_POOL / 2))
         movxx_ri(Reax, IH(RT_BUFFER_SIZE))
@@ -6867,8 +6980,7 @@ rt_void render0(rt_SIMD_INFOX *s_inf)
 
     LBL(990581) /* OO_sd1 */
 
-        movxx_ld(Rebx, Mebp, inf_THNDX)
-        mulxx_ri(Rebx, IV(RT_BUFFER_POOL))
+        movxx_ld(Rebx, Mebp, inf_BFR_P)
         movwx_ri(Redx, IB(RT_FLAG_SIDE_INNER))
         mulwx_ri(Redx, IV(RT_BUFFER_POOL / 2))
         movxx_ri(Reax, IH(RT_BUFFER_SIZE))
@@ -7223,7 +7335,7 @@ rt_void render0(rt_SIMD_INFOX *s_inf)
 
 #if RT_FEAT_MULTITHREADING
 
-        movxx_ld(Reax, Mebp, inf_THNUM)
+        movxx_ld(Reax, Mebp, inf_ROW_U)
         addxx_st(Reax, Mebp, inf_FRM_Y)
 
 #else /* RT_FEAT_MULTITHREADING */
@@ -7254,8 +7366,7 @@ rt_void render0(rt_SIMD_INFOX *s_inf)
     LBL(390331) /* TO_mtr */
 
         /* outer side */
-        movxx_ld(Rebx, Mebp, inf_THNDX)
-        mulxx_ri(Rebx, IV(RT_BUFFER_POOL))
+        movxx_ld(Rebx, Mebp, inf_BFR_P)
         movwx_ri(Redx, IB(RT_FLAG_SIDE_OUTER))
         mulwx_ri(Redx, IV(RT_BUFFER_POOL / 2))
         movxx_ri(Reax, IH(RT_BUFFER_SIZE))
@@ -7304,8 +7415,7 @@ rt_void render0(rt_SIMD_INFOX *s_inf)
     LBL(390581) /* TO_sd1 */
 
         /* inner side */
-        movxx_ld(Rebx, Mebp, inf_THNDX)
-        mulxx_ri(Rebx, IV(RT_BUFFER_POOL))
+        movxx_ld(Rebx, Mebp, inf_BFR_P)
         movwx_ri(Redx, IB(RT_FLAG_SIDE_INNER))
         mulwx_ri(Redx, IV(RT_BUFFER_POOL / 2))
         movxx_ri(Reax, IH(RT_BUFFER_SIZE))
@@ -7380,7 +7490,7 @@ rt_void render0(rt_SIMD_INFOX *s_inf)
 
 #if RT_FEAT_MULTITHREADING
 
-        movxx_ld(Reax, Mebp, inf_THNDX)
+        movxx_ld(Reax, Mebp, inf_ROW_S)
         movxx_st(Reax, Mebp, inf_FRM_Y)
 
 #else /* RT_FEAT_MULTITHREADING */
@@ -7392,7 +7502,11 @@ rt_void render0(rt_SIMD_INFOX *s_inf)
     LBL(370676) /* TY_cyc */
 
         movxx_ld(Reax, Mebp, inf_FRM_Y)
+#if RT_FEAT_MULTITHREADING
+        cmjxx_rm(Reax, Mebp, inf_ROW_E,
+#else /* RT_FEAT_MULTITHREADING */
         cmjxx_rm(Reax, Mebp, inf_FRM_H,
+#endif /* RT_FEAT_MULTITHREADING */
                  LT_x, 370191f) /* TY_ini */
 
         jmpxx_lb(370923f) /* TY_out */
@@ -7597,7 +7711,7 @@ rt_void render0(rt_SIMD_INFOX *s_inf)
 
 #if RT_FEAT_MULTITHREADING
 
-        movxx_ld(Reax, Mebp, inf_THNUM)
+        movxx_ld(Reax, Mebp, inf_ROW_U)
         addxx_st(Reax, Mebp, inf_FRM_Y)
 
 #else /* RT_FEAT_MULTITHREADING */
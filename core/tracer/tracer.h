@@ -27,6 +27,7 @@
 #define RT_DATA 4 /* for rt_SIMD_CONTEXT (without SIMD-buffers) */
 #endif /* RT_DEBUG == 0 */
 
+#include <stddef.h>
 #include "rtbase.h"
 
 /******************************************************************************/
@@ -246,8 +247,36 @@ struct rt_SIMD_INFOX : public rt_SIMD_INFO
     rt_word srf_s;
 #define inf_SRF_S           DP(Q*0x100+0x06C*P+E)
 
-    rt_word pad11[36];
-#define inf_PAD11           DP(Q*0x100+0x070*P+E)
+    /* rows range (set outside) */
+
+    rt_word row_s;
+#define inf_ROW_S           DP(Q*0x100+0x070*P+E)
+
+    rt_word row_e;
+#define inf_ROW_E           DP(Q*0x100+0x074*P+E)
+
+    rt_word row_u;
+#define inf_ROW_U           DP(Q*0x100+0x078*P+E)
+
+    rt_pntr bfr_p;
+#define inf_BFR_P           DP(Q*0x100+0x07C*P+E)
+
+    /* shadow occluder cache (set outside) */
+
+    rt_pntr shw_p;
+#define inf_SHW_P           DP(Q*0x100+0x080*P+E)
+
+    rt_word shw_m;
+#define inf_SHW_M           DP(Q*0x100+0x084*P+E)
+
+    rt_word shw_l;
+#define inf_SHW_L           DP(Q*0x100+0x088*P+E)
+
+    rt_word shw_h;
+#define inf_SHW_H           DP(Q*0x100+0x08C*P+E)
+
+    rt_word pad11[28];
+#define inf_PAD11           DP(Q*0x100+0x090*P+E)
 
     rt_uelm prngf[S];
 #define inf_PRNGF           DP(Q*0x100+0x100*P)
@@ -1008,7 +1037,7 @@ struct rt_SIMD_LIGHT
     rt_real a_cnt[S];
 #define lgt_A_CNT           DP(Q*0x0A0)
 
-    rt_real a_rng[S];
+    rt_real a_rng[S]; /* squared */
 #define lgt_A_RNG           DP(Q*0x0B0)
 
 };
@@ -1019,169 +1048,231 @@ struct rt_SIMD_LIGHT
 
 /*
  * SIMD surface structure with properties.
+ * Fields read by the solvers for every element in the list are packed
+ * into the leading cache lines, fields used only on hit, in clipping or
+ * in shading are placed after them (checked at compile-time below).
  * Structure is read-only in backend.
  */
 struct rt_SIMD_SURFACE
 {
-    /* clipping accum default */
-
-    rt_elem c_def[S];
-#define srf_C_DEF           DP(Q*0x000)
-
-    /* surface position */
-
-    rt_real pos_x[S];
-#define srf_POS_X           DP(Q*0x010)
-
-    rt_real pos_y[S];
-#define srf_POS_Y           DP(Q*0x020)
-
-    rt_real pos_z[S];
-#define srf_POS_Z           DP(Q*0x030)
-
-    /* axis min clippers */
-
-    rt_real min_x[S];
-#define srf_MIN_X           DP(Q*0x040)
-
-    rt_real min_y[S];
-#define srf_MIN_Y           DP(Q*0x050)
-
-    rt_real min_z[S];
-#define srf_MIN_Z           DP(Q*0x060)
-
-    /* axis max clippers */
-
-    rt_real max_x[S];
-#define srf_MAX_X           DP(Q*0x070)
+    /* misc tags/pointers */
 
-    rt_real max_y[S];
-#define srf_MAX_Y           DP(Q*0x080)
+    rt_si32 srf_t[4];
+#define srf_SRF_T(nx)       DP(Q*0x000 + nx)
 
-    rt_real max_z[S];
-#define srf_MAX_Z           DP(Q*0x090)
+    rt_pntr msc_p[4];
+#define srf_MSC_P(nx)       DP(Q*0x000+0x010+0x000*P+E + (nx)*P)
 
-    /* axis clipping toggles (on/off) */
+    rt_si32 pad01[R*4-4-4*P];
+#define srf_PAD01           DP(Q*0x000+0x010+0x010*P)
 
-    rt_si32 min_t[R];
-#define srf_MIN_T(nx)       DP(Q*0x0A0 + nx)
+    /* clipping accum default */
 
-    rt_si32 max_t[R];
-#define srf_MAX_T(nx)       DP(Q*0x0B0 + nx)
+    rt_elem c_def[S];
+#define srf_C_DEF           DP(Q*0x040)
 
     /* surface axis mapping */
 
     rt_si32 a_map[R];
-#define srf_A_MAP(nx)       DP(Q*0x0C0 + nx)
+#define srf_A_MAP(nx)       DP(Q*0x050 + nx)
 
     rt_si32 a_sgn[R];
-#define srf_A_SGN(nx)       DP(Q*0x0D0 + nx)
+#define srf_A_SGN(nx)       DP(Q*0x060 + nx)
 
     /* sign masks */
 
     rt_uelm sbase[S];
-#define srf_SBASE           DP(Q*0x0E0)
+#define srf_SBASE           DP(Q*0x070)
 
     rt_uelm smask[S];
-#define srf_SMASK           DP(Q*0x0F0)
+#define srf_SMASK           DP(Q*0x080)
 
     /* root sorting thresholds */
 
     rt_real d_eps[S];
-#define srf_D_EPS           DP(Q*0x100)
+#define srf_D_EPS           DP(Q*0x090)
 
     rt_real t_eps[S];
-#define srf_T_EPS           DP(Q*0x110)
+#define srf_T_EPS           DP(Q*0x0A0)
 
-    /* surface pointers */
+    /* surface position */
 
-    rt_uelm srf_p[S];
-#define srf_SRF_P           DP(Q*0x120)
+    rt_real pos_x[S];
+#define srf_POS_X           DP(Q*0x0B0)
 
-    rt_uelm srf_h[S];
-#define srf_SRF_H           DP(Q*0x130)
+    rt_real pos_y[S];
+#define srf_POS_Y           DP(Q*0x0C0)
+
+    rt_real pos_z[S];
+#define srf_POS_Z           DP(Q*0x0D0)
 
     /* transform coeffs */
 
     rt_real tci_x[S];
-#define srf_TCI_X           DP(Q*0x140)
+#define srf_TCI_X           DP(Q*0x0E0)
 
     rt_real tci_y[S];
-#define srf_TCI_Y           DP(Q*0x150)
+#define srf_TCI_Y           DP(Q*0x0F0)
 
     rt_real tci_z[S];
-#define srf_TCI_Z           DP(Q*0x160)
+#define srf_TCI_Z           DP(Q*0x100)
 
 
     rt_real tcj_x[S];
-#define srf_TCJ_X           DP(Q*0x170)
+#define srf_TCJ_X           DP(Q*0x110)
 
     rt_real tcj_y[S];
-#define srf_TCJ_Y           DP(Q*0x180)
+#define srf_TCJ_Y           DP(Q*0x120)
 
     rt_real tcj_z[S];
-#define srf_TCJ_Z           DP(Q*0x190)
+#define srf_TCJ_Z           DP(Q*0x130)
 
 
     rt_real tck_x[S];
-#define srf_TCK_X           DP(Q*0x1A0)
+#define srf_TCK_X           DP(Q*0x140)
 
     rt_real tck_y[S];
-#define srf_TCK_Y           DP(Q*0x1B0)
+#define srf_TCK_Y           DP(Q*0x150)
 
     rt_real tck_z[S];
-#define srf_TCK_Z           DP(Q*0x1C0)
+#define srf_TCK_Z           DP(Q*0x160)
 
     /* geometry scaling coeffs */
 
-#define srf_SCI_O           DP(Q*0x1D0)
+#define srf_SCI_O           DP(Q*0x170)
 
     rt_real sci_x[S];
-#define srf_SCI_X           DP(Q*0x1D0)
+#define srf_SCI_X           DP(Q*0x170)
 
     rt_real sci_y[S];
-#define srf_SCI_Y           DP(Q*0x1E0)
+#define srf_SCI_Y           DP(Q*0x180)
 
     rt_real sci_z[S];
-#define srf_SCI_Z           DP(Q*0x1F0)
+#define srf_SCI_Z           DP(Q*0x190)
 
     rt_real sci_w[S];
-#define srf_SCI_W           DP(Q*0x200)
+#define srf_SCI_W           DP(Q*0x1A0)
 
 
     rt_real scj_x[S];
-#define srf_SCJ_X           DP(Q*0x210)
+#define srf_SCJ_X           DP(Q*0x1B0)
 
     rt_real scj_y[S];
-#define srf_SCJ_Y           DP(Q*0x220)
+#define srf_SCJ_Y           DP(Q*0x1C0)
 
     rt_real scj_z[S];
-#define srf_SCJ_Z           DP(Q*0x230)
+#define srf_SCJ_Z           DP(Q*0x1D0)
+
+    /* axis min clippers */
+
+    rt_real min_x[S];
+#define srf_MIN_X           DP(Q*0x1E0)
+
+    rt_real min_y[S];
+#define srf_MIN_Y           DP(Q*0x1F0)
+
+    rt_real min_z[S];
+#define srf_MIN_Z           DP(Q*0x200)
+
+    /* axis max clippers */
+
+    rt_real max_x[S];
+#define srf_MAX_X           DP(Q*0x210)
+
+    rt_real max_y[S];
+#define srf_MAX_Y           DP(Q*0x220)
+
+    rt_real max_z[S];
+#define srf_MAX_Z           DP(Q*0x230)
+
+    /* axis clipping toggles (on/off) */
+
+    rt_si32 min_t[R];
+#define srf_MIN_T(nx)       DP(Q*0x240 + nx)
+
+    rt_si32 max_t[R];
+#define srf_MAX_T(nx)       DP(Q*0x250 + nx)
+
+    /* surface pointers */
+
+    rt_uelm srf_p[S];
+#define srf_SRF_P           DP(Q*0x260)
+
+    rt_uelm srf_h[S];
+#define srf_SRF_H           DP(Q*0x270)
 
     /* surface sides */
 
     rt_elem srf_o[S];
-#define srf_SRF_O           DP(Q*0x240)
+#define srf_SRF_O           DP(Q*0x280)
 
     rt_elem srf_i[S];
-#define srf_SRF_I           DP(Q*0x250)
-
-    /* misc tags/pointers */
-
-    rt_si32 srf_t[4];
-#define srf_SRF_T(nx)       DP(Q*0x260 + nx)
+#define srf_SRF_I           DP(Q*0x290)
 
-    rt_pntr msc_p[4];
-#define srf_MSC_P(nx)       DP(Q*0x260+0x010+0x000*P+E + (nx)*P)
+    /* material/light pointers */
 
     rt_pntr mat_p[4];
-#define srf_MAT_P(nx)       DP(Q*0x260+0x010+0x010*P+E + (nx)*P)
+#define srf_MAT_P(nx)       DP(Q*0x2A0+0x000*P+E + (nx)*P)
 
     rt_pntr lst_p[4];
-#define srf_LST_P(nx)       DP(Q*0x260+0x010+0x020*P+E + (nx)*P)
+#define srf_LST_P(nx)       DP(Q*0x2A0+0x010*P+E + (nx)*P)
 
 };
 
+/*
+ * Compile-time check of surface's field offsets against DP(...) defines above,
+ * array of negative size fails to compile if the two ever get out of sync.
+ */
+#define RT_DP_ARG(dp)       RT_DP_VAL(dp)
+#define RT_DP_VAL(d0, d1, d2) d0
+
+#define RT_SRF_CHECK(fl, ex, dp)                                            \
+typedef rt_byte rt_srf_##fl[RT_DP_ARG(DP(offsetof(rt_SIMD_SURFACE, fl)+ex)) \
+                             == RT_DP_VAL(dp) ? 1 : -1];
+
+RT_SRF_CHECK(srf_t, 0, srf_SRF_T(0))
+RT_SRF_CHECK(msc_p, E, srf_MSC_P(0))
+RT_SRF_CHECK(c_def, 0, srf_C_DEF)
+RT_SRF_CHECK(a_map, 0, srf_A_MAP(0))
+RT_SRF_CHECK(a_sgn, 0, srf_A_SGN(0))
+RT_SRF_CHECK(sbase, 0, srf_SBASE)
+RT_SRF_CHECK(smask, 0, srf_SMASK)
+RT_SRF_CHECK(d_eps, 0, srf_D_EPS)
+RT_SRF_CHECK(t_eps, 0, srf_T_EPS)
+RT_SRF_CHECK(pos_x, 0, srf_POS_X)
+RT_SRF_CHECK(pos_y, 0, srf_POS_Y)
+RT_SRF_CHECK(pos_z, 0, srf_POS_Z)
+RT_SRF_CHECK(tci_x, 0, srf_TCI_X)
+RT_SRF_CHECK(tci_y, 0, srf_TCI_Y)
+RT_SRF_CHECK(tci_z, 0, srf_TCI_Z)
+RT_SRF_CHECK(tcj_x, 0, srf_TCJ_X)
+RT_SRF_CHECK(tcj_y, 0, srf_TCJ_Y)
+RT_SRF_CHECK(tcj_z, 0, srf_TCJ_Z)
+RT_SRF_CHECK(tck_x, 0, srf_TCK_X)
+RT_SRF_CHECK(tck_y, 0, srf_TCK_Y)
+RT_SRF_CHECK(tck_z, 0, srf_TCK_Z)
+RT_SRF_CHECK(sci_x, 0, srf_SCI_X)
+RT_SRF_CHECK(sci_y, 0, srf_SCI_Y)
+RT_SRF_CHECK(sci_z, 0, srf_SCI_Z)
+RT_SRF_CHECK(sci_w, 0, srf_SCI_W)
+RT_SRF_CHECK(scj_x, 0, srf_SCJ_X)
+RT_SRF_CHECK(scj_y, 0, srf_SCJ_Y)
+RT_SRF_CHECK(scj_z, 0, srf_SCJ_Z)
+RT_SRF_CHECK(min_x, 0, srf_MIN_X)
+RT_SRF_CHECK(min_y, 0, srf_MIN_Y)
+RT_SRF_CHECK(min_z, 0, srf_MIN_Z)
+RT_SRF_CHECK(max_x, 0, srf_MAX_X)
+RT_SRF_CHECK(max_y, 0, srf_MAX_Y)
+RT_SRF_CHECK(max_z, 0, srf_MAX_Z)
+RT_SRF_CHECK(min_t, 0, srf_MIN_T(0))
+RT_SRF_CHECK(max_t, 0, srf_MAX_T(0))
+RT_SRF_CHECK(srf_p, 0, srf_SRF_P)
+RT_SRF_CHECK(srf_h, 0, srf_SRF_H)
+RT_SRF_CHECK(srf_o, 0, srf_SRF_O)
+RT_SRF_CHECK(srf_i, 0, srf_SRF_I)
+RT_SRF_CHECK(mat_p, E, srf_MAT_P(0))
+RT_SRF_CHECK(lst_p, E, srf_LST_P(0))
+
 /******************************************************************************/
 /********************************   MATERIAL   ********************************/
 /******************************************************************************/
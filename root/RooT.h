@@ -72,6 +72,7 @@ rt_si32     n_simd      = 0;        /* SIMD native size (from command-line) */
 rt_si32     k_size      = 0;        /* SIMD size-factor (from command-line) */
 rt_si32     s_type      = 0;        /* SIMD sub-variant (from command-line) */
 rt_si32     t_pool      = 0;        /* Thread-pool size (from command-line) */
+rt_si32     j_spin      = RT_POOL_SPIN; /* Thread-pool spin (command-line) */
 #if RT_FULLSCREEN == 1
 rt_si32     w_size      = 0;        /* Window-rect size (from command-line) */
 #else  /* RT_FULLSCREEN */
@@ -93,6 +94,7 @@ rt_bool     q_mode      = RT_FALSE;       /* quake mode (from command-line) */
 rt_bool     q_test      = RT_FALSE;       /* quake mode (from actual scene) */
 rt_si32     u_mode      = 0; /* update/render threadoff (from command-line) */
 rt_bool     o_mode      = RT_FALSE;        /* offscreen (from command-line) */
+rt_bool     z_mode      = RT_FALSE;        /* pipelined (from command-line) */
 rt_si32     a_mode      = RT_FSAA_NO;      /* FSAA mode (from command-line) */
 
 /******************************************************************************/
@@ -127,16 +129,18 @@ rt_pntr init_threads(rt_si32 thnum, rt_Platform *pfm);
 rt_void term_threads(rt_pntr tdata, rt_si32 thnum);
 
 /*
- * Task platform-specific pool of "thnum" threads to update scene,
+ * Task platform-specific pool of "thnum" threads to update scene "scn",
  * block until finished.
  */
-rt_void update_scene(rt_pntr tdata, rt_si32 thnum, rt_si32 phase);
+rt_void update_scene(rt_pntr tdata, rt_Scene *scn,
+                     rt_si32 thnum, rt_si32 phase);
 
 /*
- * Task platform-specific pool of "thnum" threads to render scene,
+ * Task platform-specific pool of "thnum" threads to render scene "scn",
  * block until finished.
  */
-rt_void render_scene(rt_pntr tdata, rt_si32 thnum, rt_si32 phase);
+rt_void render_scene(rt_pntr tdata, rt_Scene *scn,
+                     rt_si32 thnum, rt_si32 phase);
 
 /*
  * Set current frame to screen.
@@ -787,6 +791,7 @@ rt_si32 args_init(rt_si32 argc, rt_char *argv[])
         RT_LOGI(" -k n, override SIMD size-factor, where new size is 1..4\n");
         RT_LOGI(" -s n, override SIMD sub-variant, where new type is 1.32\n");
         RT_LOGI(" -t n, override thread-pool size, where new size <= 1000\n");
+        RT_LOGI(" -j n, spin-then-park pool waits, n spins (0-park at once)\n");
         RT_LOGI(" -w n, override window-rect size, where new size is 1..9\n");
         RT_LOGI(" -w 0, activate window-less mode, full native resolution\n");
         RT_LOGI(" -x n, override x-resolution, where new x-value <= 65535\n");
@@ -800,6 +805,7 @@ rt_si32 args_init(rt_si32 argc, rt_char *argv[])
         RT_LOGI(" -t, trace mode, toggles path-tracing for quality lights\n");
         RT_LOGI(" -u n, 1-3/4 serial update/render, 5/6 update/render off\n");
         RT_LOGI(" -o, offscreen-frame mode, turns off window-rect updates\n");
+        RT_LOGI(" -z, pipelined-frame mode, render lags update by 1 frame\n");
         RT_LOGI(" -a, enable 4x antialiasing by default, 8x not supported\n");
         RT_LOGI(" -a n, enable antialiasing, 2 for 2x, 4 for 4x, 8 for 8x\n");
         RT_LOGI("options -d n  ... ... ... ... ...  -a n can all be mixed\n");
@@ -1023,6 +1029,23 @@ rt_si32 args_init(rt_si32 argc, rt_char *argv[])
                 return 0;
             }
         }
+        if (k < argc && strcmp(argv[k], "-j") == 0 && ++k < argc)
+        {
+            for (l = strlen(argv[k]), r = 1, t = 0; l > 0; l--, r *= 10)
+            {
+                t += (argv[k][l-1] - '0') * r;
+            }
+            if (t >= 0 && t <= 1000000)
+            {
+                RT_LOGI("Thread-pool spin-count overridden: %d\n", t);
+                j_spin = t;
+            }
+            else
+            {
+                RT_LOGI("Thread-pool spin-count value out of range\n");
+                return 0;
+            }
+        }
         if (k < argc && strcmp(argv[k], "-w") == 0 && ++k < argc)
         {
             t = argv[k][0] - '0';
@@ -1156,6 +1179,11 @@ rt_si32 args_init(rt_si32 argc, rt_char *argv[])
             o_mode = RT_TRUE;
             RT_LOGI("Offscreen-frame mode: %d\n", o_mode);
         }
+        if (k < argc && strcmp(argv[k], "-z") == 0 && !z_mode)
+        {
+            z_mode = RT_TRUE;
+            RT_LOGI("Pipelined-frame mode: %d\n", z_mode);
+        }
         if (k < argc && strcmp(argv[k], "-a") == 0)
         {
             rt_si32 aa_map[10] =
@@ -1226,6 +1254,7 @@ rt_si32 main_init()
         {
             sc[i] = new(pfm) rt_Scene(sc_rt[i],
                                       x_res, y_res, x_row, frame, pfm);
+            sc[i]->set_pipe(z_mode);
         }
 
         pfm->set_cur_scene(sc[d]);
@@ -49,71 +49,6 @@ pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
 #undef  RT_SETAFFINITY /* setting thread affinity is not present on macOS */
 #define RT_SETAFFINITY 0
 
-/*
- * Custom implementation of pthread barriers for macOS found at:
- * http://blog.albertarmea.com/post/47089939939/using-pthreadbarrier-on-mac-os-x
- * copied as is with minor format adjustments.
- */
-#include <errno.h>
-
-typedef int pthread_barrierattr_t;
-typedef struct
-{
-    pthread_mutex_t mutex;
-    pthread_cond_t cond;
-    int count;
-    int tripCount;
-} pthread_barrier_t;
-
-int pthread_barrier_init(pthread_barrier_t *barrier,
-                         const pthread_barrierattr_t *attr, unsigned int count)
-{
-    if(count == 0)
-    {
-        errno = EINVAL;
-        return -1;
-    }
-    if(pthread_mutex_init(&barrier->mutex, 0) < 0)
-    {
-        return -1;
-    }
-    if(pthread_cond_init(&barrier->cond, 0) < 0)
-    {
-        pthread_mutex_destroy(&barrier->mutex);
-        return -1;
-    }
-    barrier->tripCount = count;
-    barrier->count = 0;
-
-    return 0;
-}
-
-int pthread_barrier_destroy(pthread_barrier_t *barrier)
-{
-    pthread_cond_destroy(&barrier->cond);
-    pthread_mutex_destroy(&barrier->mutex);
-    return 0;
-}
-
-int pthread_barrier_wait(pthread_barrier_t *barrier)
-{
-    pthread_mutex_lock(&barrier->mutex);
-    ++(barrier->count);
-    if(barrier->count >= barrier->tripCount)
-    {
-        barrier->count = 0;
-        pthread_cond_broadcast(&barrier->cond);
-        pthread_mutex_unlock(&barrier->mutex);
-        return 1;
-    }
-    else
-    {
-        pthread_cond_wait(&barrier->cond, &(barrier->mutex));
-        pthread_mutex_unlock(&barrier->mutex);
-        return 0;
-    }
-}
-
 #endif /* __APPLE__ */
 
 /******************************************************************************/
@@ -458,7 +393,7 @@ rt_byte *s_ptr = RT_ADDRESS_MIN;
 #endif /* RT_POINTER */
 
 
-#if (RT_POINTER - RT_ADDRESS) != 0
+#if (RT_POINTER - RT_ADDRESS) != 0 || RT_HUGEPAGE != 0
 
 #include <sys/mman.h>
 
@@ -466,7 +401,45 @@ rt_byte *s_ptr = RT_ADDRESS_MIN;
 #define MAP_ANONYMOUS MAP_ANON  /* workaround for macOS compilation */
 #endif /* macOS still cannot allocate with mmap within 32-bit range */
 
-#endif /* (RT_POINTER - RT_ADDRESS) */
+#endif /* (RT_POINTER - RT_ADDRESS), RT_HUGEPAGE */
+
+#if RT_HUGEPAGE != 0
+
+/*
+ * Map memory backed by huge pages ("size" is a multiple of RT_CHUNK_HUGE),
+ * explicit huge pages fall back to transparent if none are reserved.
+ */
+static
+rt_pntr huge_map(rt_pntr hint, rt_size size)
+{
+    rt_pntr ptr = MAP_FAILED;
+
+#if RT_HUGEPAGE == 2 && (defined MAP_HUGETLB)
+
+    ptr = mmap(hint, size, PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+#endif /* RT_HUGEPAGE, MAP_HUGETLB */
+
+    if (ptr == MAP_FAILED)
+    {
+        ptr = mmap(hint, size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+#if (defined MADV_HUGEPAGE)
+
+        if (ptr != MAP_FAILED)
+        {
+            madvise(ptr, size, MADV_HUGEPAGE);
+        }
+
+#endif /* MADV_HUGEPAGE */
+    }
+
+    return ptr != MAP_FAILED ? ptr : RT_NULL;
+}
+
+#endif /* RT_HUGEPAGE */
 
 /*
  * Allocate memory from system heap.
@@ -477,6 +450,19 @@ rt_pntr sys_alloc(rt_size size)
 
 #if (RT_POINTER - RT_ADDRESS) != 0
 
+    rt_pntr ptr;
+
+#if RT_HUGEPAGE != 0
+
+    /* align next address to huge page boundary */
+    if (RT_CHUNK_IS_HUGE(size))
+    {
+        s_ptr = (rt_byte *)(((rt_size)s_ptr + (RT_CHUNK_HUGE - 1)) &
+                                            ~(rt_size)(RT_CHUNK_HUGE - 1));
+    }
+
+#endif /* RT_HUGEPAGE */
+
     /* loop around RT_ADDRESS_MAX boundary */
     /* in 64/32-bit hybrid mode addresses can't have sign bit
      * as MIPS64 sign-extends all 32-bit mem-loads by default */
@@ -485,8 +471,18 @@ rt_pntr sys_alloc(rt_size size)
         s_ptr  = RT_ADDRESS_MIN;
     }
 
-    rt_pntr ptr = mmap(s_ptr, size, PROT_READ | PROT_WRITE,
-                  MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#if RT_HUGEPAGE != 0
+
+    if (RT_CHUNK_IS_HUGE(size))
+    {
+        ptr = huge_map(s_ptr, size);
+    }
+    else
+#endif /* RT_HUGEPAGE */
+    {
+        ptr = mmap(s_ptr, size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    }
 
     /* advance with allocation granularity */
     /* in case when page-size differs from default 4096 bytes
@@ -495,7 +491,19 @@ rt_pntr sys_alloc(rt_size size)
 
 #else /* (RT_POINTER - RT_ADDRESS) */
 
-    rt_pntr ptr = malloc(size);
+    rt_pntr ptr;
+
+#if RT_HUGEPAGE != 0
+
+    if (RT_CHUNK_IS_HUGE(size))
+    {
+        ptr = huge_map(RT_NULL, size);
+    }
+    else
+#endif /* RT_HUGEPAGE */
+    {
+        ptr = malloc(size);
+    }
 
 #endif /* (RT_POINTER - RT_ADDRESS) */
 
@@ -537,7 +545,17 @@ rt_void sys_free(rt_pntr ptr, rt_size size)
 
 #else /* (RT_POINTER - RT_ADDRESS) */
 
-    free(ptr);
+#if RT_HUGEPAGE != 0
+
+    if (RT_CHUNK_IS_HUGE(size))
+    {
+        munmap(ptr, size);
+    }
+    else
+#endif /* RT_HUGEPAGE */
+    {
+        free(ptr);
+    }
 
 #endif /* (RT_POINTER - RT_ADDRESS) */
 
@@ -554,188 +572,51 @@ rt_void sys_free(rt_pntr ptr, rt_size size)
 /*****************************   MULTI-THREADING   ****************************/
 /******************************************************************************/
 
-struct rt_THREAD;
-
-/* platform-specific pool
- * of "thnum" threads */
-struct rt_THREAD_POOL
-{
-    rt_Platform        *pfm;
-    rt_si32             cmd;
-    rt_si32             thnum;
-    rt_THREAD          *thread;
-    pthread_barrier_t   barr[2];
-};
-
-/* platform-specific thread */
-struct rt_THREAD
+/*
+ * Run update slice of the scene with given "index" on the pool.
+ */
+static
+rt_void slice_update(rt_pntr data, rt_si32 index, rt_si32 phase)
 {
-    rt_THREAD_POOL     *tpool;
-    rt_si32             index;
-    pthread_t           pthr;
-};
+    ((rt_Scene *)data)->update_slice(index, phase);
+}
 
 /*
- * Worker thread's entry point.
+ * Run render slice of the scene with given "index" on the pool.
  */
-rt_pntr worker_thread(rt_pntr p)
+static
+rt_void slice_render(rt_pntr data, rt_si32 index, rt_si32 phase)
 {
-    rt_THREAD *thread = (rt_THREAD *)p;
-    rt_si32 ti = thread->index;
-
-    while (thread->tpool->cmd < 0) /* <- wait for barriers */
-    {
-        sched_yield();
-    }
-
-    while (1)
-    {
-        /* every worker-thread waits signal from main thread */
-        pthread_barrier_wait(&thread->tpool->barr[0]);
-
-        rt_Platform *pfm = thread->tpool->pfm;
-
-        if (pfm == RT_NULL)
-        {
-            break;
-        }
-
-        rt_si32 cmd = thread->tpool->cmd;
-
-        /* if one thread throws an exception,
-         * other threads are still allowed to proceed
-         * in the same run, but not in the next one */
-        if (eout == 0)
-        try
-        {
-            rt_Scene *scene = pfm->get_cur_scene();
-
-            switch (cmd & 0x3)
-            {
-                case 1:
-                scene->update_slice(ti, (cmd >> 2) & 0xFF);
-                break;
-
-                case 2:
-                scene->render_slice(ti, (cmd >> 2) & 0xFF);
-                break;
-
-                default:
-                break;
-            };
-        }
-        catch (rt_Exception e)
-        {
-            estr[ti] = e.err;
-            eout = 1;
-        }
-
-        /* every worker-thread signals to main thread when done */
-        pthread_barrier_wait(&thread->tpool->barr[1]);
-    }
-
-    /* every worker-thread signals to main thread when done */
-    pthread_barrier_wait(&thread->tpool->barr[1]);
-
-    return RT_NULL;
+    ((rt_Scene *)data)->render_slice(index, phase);
 }
 
 /*
  * Initialize platform-specific pool of "thnum" threads (< 0 - no feedback).
+ * Built-in thread pool (system.cpp) is used with spin-count from "-j",
+ * its job-queue is shared by all scenes of the platform.
  */
 rt_pntr init_threads(rt_si32 thnum, rt_Platform *pfm)
 {
     rt_bool feedback = thnum < 0 ? RT_FALSE : RT_TRUE;
     thnum = thnum < 0 ? -thnum : thnum;
 
-    eout = 0; emax = thnum;
-    estr = (rt_pstr *)malloc(sizeof(rt_pstr) * thnum);
-
-    if (estr == RT_NULL)
-    {
-        throw rt_Exception("out of memory for estr in init_threads");
-    }
-
-    memset(estr, 0, sizeof(rt_pstr) * thnum);
-
 #if RT_SETAFFINITY
 
-    cpu_set_t cpuset_pr, cpuset_th;
-    pthread_t pthr = pthread_self();
-    pthread_getaffinity_np(pthr, sizeof(cpu_set_t), &cpuset_pr);
-
-#endif /* RT_SETAFFINITY */
-
-    rt_THREAD_POOL *tpool = (rt_THREAD_POOL *)malloc(sizeof(rt_THREAD_POOL));
-
-    if (tpool == RT_NULL)
-    {
-        throw rt_Exception("out of memory for tpool in init_threads");
-    }
-
-    tpool->pfm = pfm;
-    tpool->cmd = -1;
-    tpool->thnum = thnum;
-    tpool->thread = (rt_THREAD *)malloc(sizeof(rt_THREAD) * thnum);
-
-    if (tpool->thread == RT_NULL)
+    /* with feedback, threads are limited
+     * to the number of CPUs they are pinned to */
+    if (feedback)
     {
-        throw rt_Exception("out of memory for thread data in init_threads");
+        thnum = RT_MIN(thnum, rt_ThreadPool::get_cpus());
     }
 
-    rt_si32 i, a;
-
-    for (i = 0, a = 0; i < thnum; i++, a++)
-    {
-#if RT_SETAFFINITY
-
-        while (!CPU_ISSET(a, &cpuset_pr))
-        {
-            a++;
-            if (a == CPU_SETSIZE)
-            {
-                if (feedback)
-                {
-                    thnum = i;
-                    break;
-                }
-                else
-                {
-                    a = 0;
-                }
-            }
-        }
-        if (thnum == i)
-        {
-            break;
-        }
-
-#endif /* RT_SETAFFINITY */
-
-        rt_THREAD *thread = tpool->thread;
-
-        thread[i].tpool = tpool;
-        thread[i].index = i;
-        pthread_create(&thread[i].pthr, NULL, worker_thread, &thread[i]);
-
-#if RT_SETAFFINITY
-
-        CPU_ZERO(&cpuset_th);
-        CPU_SET(a, &cpuset_th);
-        pthread_setaffinity_np(thread[i].pthr, sizeof(cpu_set_t), &cpuset_th);
-
 #endif /* RT_SETAFFINITY */
-    }
 
-    pthread_barrier_init(&tpool->barr[0], NULL, thnum + 1);
-    pthread_barrier_init(&tpool->barr[1], NULL, thnum + 1);
+    rt_ThreadPool *tpool = new rt_ThreadPool(thnum, j_spin);
 
     if (feedback)
     {
-        pfm->set_thnum(thnum);
+        pfm->set_thnum(tpool->get_thnum());
     }
-    tpool->thnum = thnum;
-    tpool->cmd = 0;
 
     return tpool;
 }
@@ -745,62 +626,27 @@ rt_pntr init_threads(rt_si32 thnum, rt_Platform *pfm)
  */
 rt_void term_threads(rt_pntr tdata, rt_si32 thnum)
 {
-    rt_si32 i;
-    rt_THREAD_POOL *tpool = (rt_THREAD_POOL *)tdata;
-
-    /* signal all worker-threads to terminate */
-    tpool->cmd = 0;
-    tpool->pfm = RT_NULL;
-    pthread_barrier_wait(&tpool->barr[0]);
-    /* wait for all worker-threads to finish */
-    pthread_barrier_wait(&tpool->barr[1]);
-
-    for (i = 0; i < tpool->thnum; i++)
-    {
-        rt_THREAD *thread = tpool->thread;
-
-        pthread_join(thread[i].pthr, NULL);
-    }
-
-    pthread_barrier_destroy(&tpool->barr[0]);
-    pthread_barrier_destroy(&tpool->barr[1]);
-
-    free(tpool->thread);
-    free(tpool);
-
-    free(estr);
-    estr = RT_NULL;
-    eout = emax = 0;
+    delete (rt_ThreadPool *)tdata;
 }
 
 /*
- * Task platform-specific pool of "thnum" threads to update scene,
+ * Task platform-specific pool of "thnum" threads to update scene "scn",
  * block until finished.
  */
-rt_void update_scene(rt_pntr tdata, rt_si32 thnum, rt_si32 phase)
+rt_void update_scene(rt_pntr tdata, rt_Scene *scn,
+                     rt_si32 thnum, rt_si32 phase)
 {
-    rt_THREAD_POOL *tpool = (rt_THREAD_POOL *)tdata;
-
-    /* signal all worker-threads to update scene */
-    tpool->cmd = 1 | ((phase & 0xFF) << 2);
-    pthread_barrier_wait(&tpool->barr[0]);
-    /* wait for all worker-threads to finish */
-    pthread_barrier_wait(&tpool->barr[1]);
+    ((rt_ThreadPool *)tdata)->run(slice_update, scn, phase);
 }
 
 /*
- * Task platform-specific pool of "thnum" threads to render scene,
+ * Task platform-specific pool of "thnum" threads to render scene "scn",
  * block until finished.
  */
-rt_void render_scene(rt_pntr tdata, rt_si32 thnum, rt_si32 phase)
+rt_void render_scene(rt_pntr tdata, rt_Scene *scn,
+                     rt_si32 thnum, rt_si32 phase)
 {
-    rt_THREAD_POOL *tpool = (rt_THREAD_POOL *)tdata;
-
-    /* signal all worker-threads to render scene */
-    tpool->cmd = 2 | ((phase & 0xFF) << 2);
-    pthread_barrier_wait(&tpool->barr[0]);
-    /* wait for all worker-threads to finish */
-    pthread_barrier_wait(&tpool->barr[1]);
+    ((rt_ThreadPool *)tdata)->run(slice_render, scn, phase);
 }
 
 /******************************************************************************/
@@ -397,8 +397,10 @@ struct rt_THREAD;
 struct rt_THREAD_POOL
 {
     rt_Platform        *pfm;
+    rt_Scene           *scene;
     rt_si32             cmd;
     rt_si32             thnum;
+    CRITICAL_SECTION    lock; /* serializes scenes */
     rt_THREAD          *thread;
     HANDLE             *pevent; /* per-thr events */
     rt_si32             windex;
@@ -442,7 +444,7 @@ DWORD WINAPI worker_thread(rt_pntr p)
         if (eout == 0)
         try
         {
-            rt_Scene *scene = pfm->get_cur_scene();
+            rt_Scene *scene = thread->tpool->scene;
 
             switch (cmd & 0x3)
             {
@@ -559,8 +561,10 @@ rt_pntr init_threads(rt_si32 thnum, rt_Platform *pfm)
     }
 
     tpool->pfm = pfm;
+    tpool->scene = RT_NULL;
     tpool->cmd = 0;
     tpool->thnum = thnum;
+    InitializeCriticalSection(&tpool->lock);
     tpool->thread = (rt_THREAD *)malloc(sizeof(rt_THREAD) * thnum);
     tpool->pevent = (HANDLE *)malloc(sizeof(HANDLE) * thnum);
 
@@ -786,6 +790,8 @@ rt_void term_threads(rt_pntr tdata, rt_si32 thnum)
         }
     }
 
+    DeleteCriticalSection(&tpool->lock);
+
     free(tpool->thread);
     free(tpool->pevent);
     free(tpool);
@@ -796,14 +802,19 @@ rt_void term_threads(rt_pntr tdata, rt_si32 thnum)
 }
 
 /*
- * Task platform-specific pool of "thnum" threads to update scene,
+ * Task platform-specific pool of "thnum" threads to update scene "scn",
  * block until finished.
  */
-rt_void update_scene(rt_pntr tdata, rt_si32 thnum, rt_si32 phase)
+rt_void update_scene(rt_pntr tdata, rt_Scene *scn,
+                     rt_si32 thnum, rt_si32 phase)
 {
     rt_THREAD_POOL *tpool = (rt_THREAD_POOL *)tdata;
 
+    /* scenes rendered from different threads take turns */
+    EnterCriticalSection(&tpool->lock);
+
     /* signal worker-event for all worker-threads to update scene */
+    tpool->scene = scn;
     tpool->cmd = 1 | ((phase & 0xFF) << 2);
     SetEvent(tpool->wevent[tpool->windex]);
     /* wait for control-threads to signal control-events for their groups */
@@ -812,17 +823,24 @@ rt_void update_scene(rt_pntr tdata, rt_si32 thnum, rt_si32 phase)
     ResetEvent(tpool->wevent[tpool->windex]);
     /* swap worker-event for the main thread to signal */
     tpool->windex = 1 - tpool->windex;
+
+    LeaveCriticalSection(&tpool->lock);
 }
 
 /*
- * Task platform-specific pool of "thnum" threads to render scene,
+ * Task platform-specific pool of "thnum" threads to render scene "scn",
  * block until finished.
  */
-rt_void render_scene(rt_pntr tdata, rt_si32 thnum, rt_si32 phase)
+rt_void render_scene(rt_pntr tdata, rt_Scene *scn,
+                     rt_si32 thnum, rt_si32 phase)
 {
     rt_THREAD_POOL *tpool = (rt_THREAD_POOL *)tdata;
 
+    /* scenes rendered from different threads take turns */
+    EnterCriticalSection(&tpool->lock);
+
     /* signal worker-event for all worker-threads to render scene */
+    tpool->scene = scn;
     tpool->cmd = 2 | ((phase & 0xFF) << 2);
     SetEvent(tpool->wevent[tpool->windex]);
     /* wait for control-threads to signal control-events for their groups */
@@ -831,6 +849,8 @@ rt_void render_scene(rt_pntr tdata, rt_si32 thnum, rt_si32 phase)
     ResetEvent(tpool->wevent[tpool->windex]);
     /* swap worker-event for the main thread to signal */
     tpool->windex = 1 - tpool->windex;
+
+    LeaveCriticalSection(&tpool->lock);
 }
 
 /******************************************************************************/
@@ -39,7 +39,8 @@ LIB_PATH =
 
 LIB_LIST =                                  \
         -lm                                 \
-        -lstdc++
+        -lstdc++                            \
+        -lpthread
 
 
 build: core_test_x64_32 core_test_x64_64 core_test_x64f32 core_test_x64f64
@@ -100,6 +101,15 @@ core_test_x64f64:
         -DRT_EMBED_STDOUT=0 -DRT_EMBED_FILEIO=0 -DRT_EMBED_TEX=1 \
         ${INC_PATH} ${SRC_LIST} ${LIB_PATH} ${LIB_LIST} -o core_test.x64f64
 
+core_test_x64f32h:
+	g++ -O3 -g \
+        -DRT_LINUX -DRT_X64 -DRT_128=2+4+8 -DRT_256_R8=4 -DRT_256=1+2+8 \
+        -DRT_512_R8=1+2 -DRT_512=1+2 -DRT_1K4=1+2 -DRT_SIMD_COMPAT_SSE=2 \
+        -DRT_POINTER=64 -DRT_ADDRESS=64 -DRT_ELEMENT=32 -DRT_ENDIAN=0 \
+        -DRT_DEBUG=0 -DRT_PATH="../" -DRT_HUGEPAGE=1 \
+        -DRT_EMBED_STDOUT=0 -DRT_EMBED_FILEIO=0 -DRT_EMBED_TEX=1 \
+        ${INC_PATH} ${SRC_LIST} ${LIB_PATH} ${LIB_LIST} -o core_test.x64f32h
+
 
 core_test.x64_32:
 	clang++ -O3 -g \
@@ -174,3 +184,5 @@ core_test.x64f64:
 # use (replace): RT_ADDRESS=32, rename the binary to core_test.x64_**
 # 64-bit packed SIMD mode (fp64/int64) is supported on 64-bit targets,
 # use (replace): RT_ELEMENT=64, rename the binary to core_test.x64*64
+# Heap's large chunks backed by transparent huge pages (RT_HUGEPAGE=1):
+# make -f core_make_x64.mk core_test_x64f32h
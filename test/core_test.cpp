@@ -14,7 +14,7 @@
 /*******************************   DEFINITIONS   ******************************/
 /******************************************************************************/
 
-#define SUB_TEST            18
+#define SUB_TEST            22
 #define CYC_SIZE            3
 
 #define RT_X_RES            800
@@ -61,6 +61,12 @@ rt_bool     l_mode      = RT_FALSE;     /* log-off mode (from command-line) */
 rt_bool     o_mode      = RT_FALSE;     /* optimal mode (from command-line) */
 rt_bool     q_mode      = RT_FALSE;     /* quality mode (from command-line) */
 rt_bool     q_test      = RT_FALSE;     /* quality mode (from actual scene) */
+rt_bool     q_scene     = RT_FALSE;     /* quality mode (forced by subtest) */
+rt_bool     d_scene     = RT_FALSE;    /* animated scene (forced by subtest) */
+rt_si32     p_scene     = 0;        /* pipelined mode (forced by subtest) */
+rt_si32     a_scene     = 0;          /* async ring size (forced by subtest) */
+rt_si32     e_scene     = 0;         /* async error count (forced by subtest) */
+rt_si32     e_anim      = 0;         /* async errors armed (thrown by animator) */
 rt_si32     a_mode      = RT_FSAA_NO;   /* antialiasing (from command-line) */
 
 /*
@@ -186,6 +192,75 @@ rt_void frame_max(rt_ui32 *fd)
  */
 rt_Platform pfm(sys_alloc, sys_free);
 
+/*
+ * Render "num" frames with async render into a ring of "a_scene" frames,
+ * waiting for the oldest frame in flight before its slot is reused,
+ * "e_scene" extra frames submitted first fail in animators (armed here)
+ * and their errors must reach "wait",
+ * the last frame is copied to scene's own frame for comparison.
+ */
+rt_void render_async(rt_si32 num)
+{
+    rt_si32 j, k, n = 0;
+    rt_ui32 *f = RT_NULL;
+    rt_bool s = RT_FALSE;
+
+    scene->set_ring(a_scene);
+    e_anim = e_scene;
+
+    num += e_scene;
+
+    for (j = 0, k = 0; k < num; )
+    {
+        if (j < num && j - k < a_scene)
+        {
+            scene->submit(q_test ? 0 : RT_MAX(j - e_scene, 0) * f_time);
+            j++;
+            continue;
+        }
+
+        try
+        {
+            f = scene->wait(k);
+        }
+        catch (rt_Exception e)
+        {
+            f = RT_NULL;
+            n++;
+        }
+
+        k++;
+    }
+
+    /* fence of the first frame is stale once its slot is reused */
+    try
+    {
+        scene->poll(0);
+    }
+    catch (rt_Exception e)
+    {
+        s = RT_TRUE;
+    }
+
+    scene->set_ring(0);
+    e_anim = 0;
+
+    if (n != e_scene)
+    {
+        throw rt_Exception("errors in async render not passed on to wait");
+    }
+
+    if (s != (num > a_scene))
+    {
+        throw rt_Exception("stale fence in async render not rejected");
+    }
+
+    if (f != RT_NULL)
+    {
+        frame_cpy(scene->get_frame(), f);
+    }
+}
+
 /******************************************************************************/
 /*******************************   SUB TEST  1   ******************************/
 /******************************************************************************/
@@ -474,6 +549,117 @@ rt_void o_test18()
 
 #endif /* SUB_TEST 18 */
 
+/******************************************************************************/
+/*******************************   SUB TEST 19   ******************************/
+/******************************************************************************/
+
+#if SUB_TEST >= 19
+
+#include "scn_test12.h"
+
+/*
+ * Nested arrays of subtest 12 rendered with path-tracing regardless of -q,
+ * as path-tracer flushes SIMD-buffers of every node in the list (arrays too),
+ * path-traced frames may differ across runs by noise, as with -q.
+ */
+rt_void o_test19()
+{
+    scene = new(&pfm) rt_Scene(&scn_test12::sc_root,
+                               x_res, y_res, x_row, RT_NULL, &pfm);
+    q_scene = RT_TRUE;
+}
+
+#endif /* SUB_TEST 19 */
+
+/******************************************************************************/
+/*******************************   SUB TEST 20   ******************************/
+/******************************************************************************/
+
+#if SUB_TEST >= 20
+
+#include "scn_test20.h"
+
+/*
+ * Light with limited range, surfaces beyond it are culled
+ * from its lists in optimized run only, so both runs match
+ * only if the backend cuts the light off at the same range.
+ */
+rt_void o_test20()
+{
+    scene = new(&pfm) rt_Scene(&scn_test20::sc_root,
+                               x_res, y_res, x_row, RT_NULL, &pfm);
+}
+
+#endif /* SUB_TEST 20 */
+
+/******************************************************************************/
+/*******************************   SUB TEST 21   ******************************/
+/******************************************************************************/
+
+#if SUB_TEST >= 21
+
+#include "scn_test21.h"
+
+/*
+ * Animator of the ball's orbit, throws while errors are armed,
+ * thus the ball stays in place in the frames which failed.
+ */
+rt_void an_test21(rt_time time, rt_time last_time,
+                  rt_TRANSFORM3D *trm, rt_pntr pobj)
+{
+    if (e_anim > 0)
+    {
+        e_anim--;
+        throw rt_Exception("error in animator");
+    }
+
+    scn_test21::an_ball01(time, last_time, trm, pobj);
+}
+
+/*
+ * Animated scene rendered into a ring of 2 frames in optimized run,
+ * the first frame fails in its animator and the error must reach "wait",
+ * the last frame must match synchronous render of unoptimized run.
+ */
+rt_void o_test21()
+{
+    scn_test21::ob_orbit01[0].f_anim = an_test21;
+
+    scene = new(&pfm) rt_Scene(&scn_test21::sc_root,
+                               x_res, y_res, x_row, RT_NULL, &pfm);
+    d_scene = RT_TRUE;
+    a_scene = 2;
+    e_scene = 1;
+}
+
+#endif /* SUB_TEST 21 */
+
+/******************************************************************************/
+/*******************************   SUB TEST 22   ******************************/
+/******************************************************************************/
+
+#if SUB_TEST >= 22
+
+#include "scn_test21.h"
+
+/*
+ * Animated scene of subtest 21 rendered in pipelined mode in optimized run,
+ * with one more call to render the output lags by, so that lagged frame
+ * must match sequential render of unoptimized run,
+ * animators of the next frame run concurrently with the render.
+ */
+rt_void o_test22()
+{
+    scn_test21::ob_orbit01[0].f_anim = scn_test21::an_ball01;
+
+    scene = new(&pfm) rt_Scene(&scn_test21::sc_root,
+                               x_res, y_res, x_row, RT_NULL, &pfm);
+    d_scene = RT_TRUE;
+    p_scene = 1;
+}
+
+#endif /* SUB_TEST 22 */
+
 /******************************************************************************/
 /*********************************   TABLES   *********************************/
 /******************************************************************************/
@@ -553,6 +739,22 @@ testXX o_test[SUB_TEST] =
 #if SUB_TEST >= 18
     o_test18,
 #endif /* SUB_TEST 18 */
+
+#if SUB_TEST >= 19
+    o_test19,
+#endif /* SUB_TEST 19 */
+
+#if SUB_TEST >= 20
+    o_test20,
+#endif /* SUB_TEST 20 */
+
+#if SUB_TEST >= 21
+    o_test21,
+#endif /* SUB_TEST 21 */
+
+#if SUB_TEST >= 22
+    o_test22,
+#endif /* SUB_TEST 22 */
 };
 
 /******************************************************************************/
@@ -971,7 +1173,9 @@ rt_si32 main(rt_si32 argc, rt_char *argv[])
                     o_mode ? "o" : q_mode ? "p" : " ",  q_mode ? "q" : " ");
     }
 
-    rt_si32 i, j;
+    rt_si32 i, j, looks, hits;
+    rt_ui64 s_looks, s_hits;
+    rt_HEAP_STATS hs;
 
     for (i = n_init; i <= n_done; i++)
     {
@@ -988,10 +1192,15 @@ rt_si32 main(rt_si32 argc, rt_char *argv[])
 
             /* ------------ test run0 ---------- */
 
+            q_scene = RT_FALSE;
+            d_scene = RT_FALSE;
+            p_scene = 0;
+            a_scene = 0;
+            e_scene = 0;
             o_test[i]();
 
             scene->set_opts(RT_OPTS_NONE);
-            q_test = scene->set_pton(q_mode);
+            q_test = scene->set_pton(q_mode || q_scene);
 
             time1 = get_time();
 
@@ -1028,22 +1237,42 @@ rt_si32 main(rt_si32 argc, rt_char *argv[])
 
             /* ------------ test run1 ---------- */
 
+            q_scene = RT_FALSE;
+            d_scene = RT_FALSE;
+            p_scene = 0;
+            a_scene = 0;
+            e_scene = 0;
             o_test[i]();
 
             scene->set_opts(RT_OPTS_FULL);
-            q_test = scene->set_pton(q_mode);
+            q_test = scene->set_pton(q_mode || q_scene);
 
             time1 = get_time();
 
-            for (j = 0; j < r_test; j++)
+            if (a_scene != 0)
             {
-                scene->render(q_test ? 0 : j * f_time);
+                render_async(r_test);
+            }
+            else
+            {
+                scene->set_pipe(p_scene);
+
+                for (j = 0; j < r_test + p_scene; j++)
+                {
+                    scene->render(q_test ? 0 : j * f_time);
+                }
             }
 
             time2 = get_time();
             tF = time2 - time1;
             if (!l_mode) RT_LOGI("Time F   = %6d\n", (rt_si32)tF);
 
+            /* shadow occluder cache over all frames of optimized run */
+            scene->get_shadow_stats(&s_looks, &s_hits);
+            if (!l_mode && s_looks != 0)
+            RT_LOGI("Shadow H = %6" PR_Z "u of %" PR_Z "u lookups\n",
+                                                            s_hits, s_looks);
+
             if (h_mode)
             {
                 scene->render_num(x_res-30, 10, -1, 2, 0);
@@ -1080,6 +1309,25 @@ rt_si32 main(rt_si32 argc, rt_char *argv[])
 
             } /* --<----<-- skip diff --<----<-- */
 
+            /* lists of static scene are only built in the first frame */
+            scene->get_lists_stats(&looks, &hits);
+            if (!d_scene && looks - hits > 1)
+            {
+                if (!l_mode)
+                RT_LOGE("Lists rebuilt in %d of %d static frames\n",
+                                                    looks - hits, looks);
+            }
+
+            /* pools grow to fit frames during warm-up (the first frame),
+             * then the last frame's spans must fit in one chunk per pool */
+            scene->get_stats(&hs);
+            if (r_test > 1 && hs.span_grows != 0)
+            {
+                if (!l_mode)
+                RT_LOGE("Pools overflowed %d times in the last frame\n",
+                                                            hs.span_grows);
+            }
+
             delete scene;
             scene = RT_NULL;
         }
@@ -1244,7 +1492,7 @@ rt_time get_time()
     return (rt_time)(tm.tv_sec * 1000 + tm.tv_usec / 1000);
 }
 
-#if (RT_POINTER - RT_ADDRESS) != 0
+#if (RT_POINTER - RT_ADDRESS) != 0 || RT_HUGEPAGE != 0
 
 #include <sys/mman.h>
 
@@ -1252,7 +1500,45 @@ rt_time get_time()
 #define MAP_ANONYMOUS MAP_ANON  /* workaround for macOS compilation */
 #endif /* macOS still cannot allocate with mmap within 32-bit range */
 
-#endif /* (RT_POINTER - RT_ADDRESS) */
+#endif /* (RT_POINTER - RT_ADDRESS), RT_HUGEPAGE */
+
+#if RT_HUGEPAGE != 0
+
+/*
+ * Map memory backed by huge pages ("size" is a multiple of RT_CHUNK_HUGE),
+ * explicit huge pages fall back to transparent if none are reserved.
+ */
+static
+rt_pntr huge_map(rt_pntr hint, rt_size size)
+{
+    rt_pntr ptr = MAP_FAILED;
+
+#if RT_HUGEPAGE == 2 && (defined MAP_HUGETLB)
+
+    ptr = mmap(hint, size, PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+#endif /* RT_HUGEPAGE, MAP_HUGETLB */
+
+    if (ptr == MAP_FAILED)
+    {
+        ptr = mmap(hint, size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+#if (defined MADV_HUGEPAGE)
+
+        if (ptr != MAP_FAILED)
+        {
+            madvise(ptr, size, MADV_HUGEPAGE);
+        }
+
+#endif /* MADV_HUGEPAGE */
+    }
+
+    return ptr != MAP_FAILED ? ptr : RT_NULL;
+}
+
+#endif /* RT_HUGEPAGE */
 
 /*
  * Allocate memory from system heap.
@@ -1262,6 +1548,19 @@ rt_pntr sys_alloc(rt_size size)
 {
 #if (RT_POINTER - RT_ADDRESS) != 0
 
+    rt_pntr ptr;
+
+#if RT_HUGEPAGE != 0
+
+    /* align next address to huge page boundary */
+    if (RT_CHUNK_IS_HUGE(size))
+    {
+        s_ptr = (rt_byte *)(((rt_size)s_ptr + (RT_CHUNK_HUGE - 1)) &
+                                            ~(rt_size)(RT_CHUNK_HUGE - 1));
+    }
+
+#endif /* RT_HUGEPAGE */
+
     /* loop around RT_ADDRESS_MAX boundary */
     /* in 64/32-bit hybrid mode addresses can't have sign bit
      * as MIPS64 sign-extends all 32-bit mem-loads by default */
@@ -1270,8 +1569,18 @@ rt_pntr sys_alloc(rt_size size)
         s_ptr  = RT_ADDRESS_MIN;
     }
 
-    rt_pntr ptr = mmap(s_ptr, size, PROT_READ | PROT_WRITE,
-                  MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#if RT_HUGEPAGE != 0
+
+    if (RT_CHUNK_IS_HUGE(size))
+    {
+        ptr = huge_map(s_ptr, size);
+    }
+    else
+#endif /* RT_HUGEPAGE */
+    {
+        ptr = mmap(s_ptr, size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    }
 
     /* advance with allocation granularity */
     /* in case when page-size differs from default 4096 bytes
@@ -1280,7 +1589,19 @@ rt_pntr sys_alloc(rt_size size)
 
 #else /* (RT_POINTER - RT_ADDRESS) */
 
-    rt_pntr ptr = malloc(size);
+    rt_pntr ptr;
+
+#if RT_HUGEPAGE != 0
+
+    if (RT_CHUNK_IS_HUGE(size))
+    {
+        ptr = huge_map(RT_NULL, size);
+    }
+    else
+#endif /* RT_HUGEPAGE */
+    {
+        ptr = malloc(size);
+    }
 
 #endif /* (RT_POINTER - RT_ADDRESS) */
 
@@ -1319,7 +1640,17 @@ rt_void sys_free(rt_pntr ptr, rt_size size)
 
 #else /* (RT_POINTER - RT_ADDRESS) */
 
-    free(ptr);
+#if RT_HUGEPAGE != 0
+
+    if (RT_CHUNK_IS_HUGE(size))
+    {
+        munmap(ptr, size);
+    }
+    else
+#endif /* RT_HUGEPAGE */
+    {
+        free(ptr);
+    }
 
 #endif /* (RT_POINTER - RT_ADDRESS) */
 